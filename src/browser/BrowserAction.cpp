@@ -51,9 +51,8 @@ QJsonObject BrowserAction::readResponse(const QJsonObject& json)
         return getErrorReply(action, ERROR_KEEPASS_INCORRECT_ACTION);
     }
 
-    QMutexLocker locker(&m_mutex);
     if (action.compare("change-public-keys", Qt::CaseSensitive) != 0 && !m_browserService.isDatabaseOpened()) {
-        if (m_clientPublicKey.isEmpty()) {
+        if (clientPublicKey().isEmpty()) {
             return getErrorReply(action, ERROR_KEEPASS_CLIENT_PUBLIC_KEY_NOT_RECEIVED);
         } else if (!m_browserService.openDatabase(triggerUnlock)) {
             return getErrorReply(action, ERROR_KEEPASS_DATABASE_NOT_OPENED);
@@ -80,6 +79,8 @@ QJsonObject BrowserAction::handleAction(const QJsonObject& json)
         return handleTestAssociate(json, action);
     } else if (action.compare("get-logins", Qt::CaseSensitive) == 0) {
         return handleGetLogins(json, action);
+    } else if (action.compare("get-logins-batch", Qt::CaseSensitive) == 0) {
+        return handleGetLoginsBatch(json, action);
     } else if (action.compare("generate-password", Qt::CaseSensitive) == 0) {
         return handleGeneratePassword(json, action);
     } else if (action.compare("set-login", Qt::CaseSensitive) == 0) {
@@ -181,8 +182,7 @@ QJsonObject BrowserAction::handleAssociate(const QJsonObject& json, const QStrin
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
 
-    QMutexLocker locker(&m_mutex);
-    if (key.compare(m_clientPublicKey, Qt::CaseSensitive) == 0) {
+    if (key.compare(clientPublicKey(), Qt::CaseSensitive) == 0) {
         // Check for identification key. If it's not found, ensure backwards compatibility and use the current public
         // key
         const QString idKey = decrypted.value("idKey").toString();
@@ -191,7 +191,7 @@ QJsonObject BrowserAction::handleAssociate(const QJsonObject& json, const QStrin
             return getErrorReply(action, ERROR_KEEPASS_ACTION_CANCELLED_OR_DENIED);
         }
 
-        m_associated = true;
+        setAssociated(true);
         const QString newNonce = incrementNonce(nonce);
 
         QJsonObject message = buildMessage(newNonce);
@@ -220,13 +220,12 @@ QJsonObject BrowserAction::handleTestAssociate(const QJsonObject& json, const QS
         return getErrorReply(action, ERROR_KEEPASS_DATABASE_NOT_OPENED);
     }
 
-    QMutexLocker locker(&m_mutex);
     const QString key = m_browserService.getKey(id);
     if (key.isEmpty() || key.compare(responseKey, Qt::CaseSensitive) != 0) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
 
-    m_associated = true;
+    setAssociated(true);
     const QString newNonce = incrementNonce(nonce);
 
     QJsonObject message = buildMessage(newNonce);
@@ -242,8 +241,7 @@ QJsonObject BrowserAction::handleGetLogins(const QJsonObject& json, const QStrin
     const QString nonce = json.value("nonce").toString();
     const QString encrypted = json.value("message").toString();
 
-    QMutexLocker locker(&m_mutex);
-    if (!m_associated) {
+    if (!isAssociated()) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
 
@@ -286,6 +284,66 @@ QJsonObject BrowserAction::handleGetLogins(const QJsonObject& json, const QStrin
     return buildResponse(action, message, newNonce);
 }
 
+// Same as get-logins for several frames of a page, answered with one message
+QJsonObject BrowserAction::handleGetLoginsBatch(const QJsonObject& json, const QString& action)
+{
+    const QString hash = getDatabaseHash();
+    const QString nonce = json.value("nonce").toString();
+    const QString encrypted = json.value("message").toString();
+
+    if (!isAssociated()) {
+        return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
+    }
+
+    const QJsonObject decrypted = decryptMessage(encrypted, nonce);
+    if (decrypted.isEmpty()) {
+        return getErrorReply(action, ERROR_KEEPASS_CANNOT_DECRYPT_MESSAGE);
+    }
+
+    const QJsonArray requests = decrypted.value("requests").toArray();
+    if (requests.isEmpty()) {
+        return getErrorReply(action, ERROR_KEEPASS_NO_URL_PROVIDED);
+    }
+
+    const QJsonArray keys = decrypted.value("keys").toArray();
+
+    StringPairList keyList;
+    for (const QJsonValue val : keys) {
+        const QJsonObject keyObject = val.toObject();
+        keyList.push_back(qMakePair(keyObject.value("id").toString(), keyObject.value("key").toString()));
+    }
+
+    const QString id = decrypted.value("id").toString();
+    const QJsonArray matches = m_browserService.findMatchingEntriesBatch(id, requests, keyList);
+
+    int total = 0;
+    QJsonArray results;
+    for (int i = 0; i < requests.size(); ++i) {
+        const QJsonArray users = matches.at(i).toArray();
+        total += users.count();
+
+        QJsonObject result;
+        result["url"] = requests.at(i).toObject().value("url");
+        result["count"] = users.count();
+        result["entries"] = users;
+        results.append(result);
+    }
+
+    if (total == 0) {
+        return getErrorReply(action, ERROR_KEEPASS_NO_LOGINS_FOUND);
+    }
+
+    const QString newNonce = incrementNonce(nonce);
+
+    QJsonObject message = buildMessage(newNonce);
+    message["count"] = total;
+    message["results"] = results;
+    message["hash"] = hash;
+    message["id"] = id;
+
+    return buildResponse(action, message, newNonce);
+}
+
 QJsonObject BrowserAction::handleGeneratePassword(const QJsonObject& json, const QString& action)
 {
     auto nonce = json.value("nonce").toString();
@@ -315,8 +373,7 @@ QJsonObject BrowserAction::handleSetLogin(const QJsonObject& json, const QString
     const QString nonce = json.value("nonce").toString();
     const QString encrypted = json.value("message").toString();
 
-    QMutexLocker locker(&m_mutex);
-    if (!m_associated) {
+    if (!isAssociated()) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
 
@@ -374,7 +431,6 @@ QJsonObject BrowserAction::handleLockDatabase(const QJsonObject& json, const QSt
 
     QString command = decrypted.value("action").toString();
     if (!command.isEmpty() && command.compare("lock-database", Qt::CaseSensitive) == 0) {
-        QMutexLocker locker(&m_mutex);
         m_browserService.lockDatabase();
 
         const QString newNonce = incrementNonce(nonce);
@@ -392,8 +448,7 @@ QJsonObject BrowserAction::handleGetDatabaseGroups(const QJsonObject& json, cons
     const QString nonce = json.value("nonce").toString();
     const QString encrypted = json.value("message").toString();
 
-    QMutexLocker locker(&m_mutex);
-    if (!m_associated) {
+    if (!isAssociated()) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
 
@@ -426,8 +481,7 @@ QJsonObject BrowserAction::handleCreateNewGroup(const QJsonObject& json, const Q
     const QString nonce = json.value("nonce").toString();
     const QString encrypted = json.value("message").toString();
 
-    QMutexLocker locker(&m_mutex);
-    if (!m_associated) {
+    if (!isAssociated()) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
 
@@ -456,6 +510,36 @@ QJsonObject BrowserAction::handleCreateNewGroup(const QJsonObject& json, const Q
     return buildResponse(action, message, newNonce);
 }
 
+/**
+ * @return true for actions that neither modify the database nor need user interaction,
+ *         these may be handled concurrently outside of the GUI thread
+ */
+bool BrowserAction::isReadOnlyAction(const QString& action)
+{
+    return action.compare("get-logins", Qt::CaseSensitive) == 0
+           || action.compare("get-logins-batch", Qt::CaseSensitive) == 0
+           || action.compare("get-databasehash", Qt::CaseSensitive) == 0
+           || action.compare("test-associate", Qt::CaseSensitive) == 0;
+}
+
+bool BrowserAction::isAssociated()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_associated;
+}
+
+void BrowserAction::setAssociated(bool associated)
+{
+    QMutexLocker locker(&m_mutex);
+    m_associated = associated;
+}
+
+QString BrowserAction::clientPublicKey()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_clientPublicKey;
+}
+
 QJsonObject BrowserAction::getErrorReply(const QString& action, const int errorCode) const
 {
     QJsonObject response;
@@ -539,7 +623,6 @@ QString BrowserAction::getReturnValue(const BrowserService::ReturnValue returnVa
 
 QString BrowserAction::getDatabaseHash()
 {
-    QMutexLocker locker(&m_mutex);
     QByteArray hash =
         QCryptographicHash::hash(m_browserService.getDatabaseRootUuid().toUtf8(), QCryptographicHash::Sha256).toHex();
     return QString(hash);
@@ -547,7 +630,6 @@ QString BrowserAction::getDatabaseHash()
 
 QString BrowserAction::getLegacyDatabaseHash()
 {
-    QMutexLocker locker(&m_mutex);
     QByteArray hash =
         QCryptographicHash::hash(
             (m_browserService.getDatabaseRootUuid() + m_browserService.getDatabaseRecycleBinUuid()).toUtf8(),
@@ -586,11 +668,19 @@ QJsonObject BrowserAction::decryptMessage(const QString& message, const QString&
 
 QString BrowserAction::encrypt(const QString& plaintext, const QString& nonce)
 {
-    QMutexLocker locker(&m_mutex);
+    QString clientPublicKey;
+    QString secretKey;
+    {
+        // Only the keys are shared, the crypto itself runs concurrently
+        QMutexLocker locker(&m_mutex);
+        clientPublicKey = m_clientPublicKey;
+        secretKey = m_secretKey;
+    }
+
     const QByteArray ma = plaintext.toUtf8();
     const QByteArray na = base64Decode(nonce);
-    const QByteArray ca = base64Decode(m_clientPublicKey);
-    const QByteArray sa = base64Decode(m_secretKey);
+    const QByteArray ca = base64Decode(clientPublicKey);
+    const QByteArray sa = base64Decode(secretKey);
 
     std::vector<unsigned char> m(ma.cbegin(), ma.cend());
     std::vector<unsigned char> n(na.cbegin(), na.cend());
@@ -614,11 +704,19 @@ QString BrowserAction::encrypt(const QString& plaintext, const QString& nonce)
 
 QByteArray BrowserAction::decrypt(const QString& encrypted, const QString& nonce)
 {
-    QMutexLocker locker(&m_mutex);
+    QString clientPublicKey;
+    QString secretKey;
+    {
+        // Only the keys are shared, the crypto itself runs concurrently
+        QMutexLocker locker(&m_mutex);
+        clientPublicKey = m_clientPublicKey;
+        secretKey = m_secretKey;
+    }
+
     const QByteArray ma = base64Decode(encrypted);
     const QByteArray na = base64Decode(nonce);
-    const QByteArray ca = base64Decode(m_clientPublicKey);
-    const QByteArray sa = base64Decode(m_secretKey);
+    const QByteArray ca = base64Decode(clientPublicKey);
+    const QByteArray sa = base64Decode(secretKey);
 
     std::vector<unsigned char> m(ma.cbegin(), ma.cend());
     std::vector<unsigned char> n(na.cbegin(), na.cend());
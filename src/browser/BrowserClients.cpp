@@ -28,9 +28,13 @@ BrowserClients::BrowserClients(BrowserService& browserService)
 }
 
 QJsonObject BrowserClients::readResponse(const QByteArray& arr)
+{
+    return readResponse(byteArrayToJson(arr));
+}
+
+QJsonObject BrowserClients::readResponse(const QJsonObject& message)
 {
     QJsonObject json;
-    const QJsonObject message = byteArrayToJson(arr);
     const QString clientID = getClientID(message);
 
     if (!clientID.isEmpty()) {
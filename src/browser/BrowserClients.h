@@ -46,9 +46,10 @@ public:
     ~BrowserClients() = default;
 
     QJsonObject readResponse(const QByteArray& arr);
+    QJsonObject readResponse(const QJsonObject& message);
+    QJsonObject byteArrayToJson(const QByteArray& arr) const;
 
 private:
-    QJsonObject byteArrayToJson(const QByteArray& arr) const;
     QString getClientID(const QJsonObject& json) const;
     ClientPtr getClient(const QString& clientID);
 
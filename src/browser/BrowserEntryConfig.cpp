@@ -80,9 +80,41 @@ void BrowserEntryConfig::setRealm(const QString& realm)
     m_realm = realm;
 }
 
+/**
+ * Get the access rules of an entry without parsing its settings every time.
+ *
+ * The settings are decoded on first use and cached by the entry until it
+ * changes, e.g. when its custom data is modified.
+ *
+ * @param entry entry to get the rules for
+ * @return decoded rules
+ */
+BrowserAccessRules BrowserEntryConfig::accessRules(const Entry* entry)
+{
+    return entry->decodedCustomData(KEEPASSXCBROWSER_NAME, &BrowserEntryConfig::decodeAccessRules)
+        .value<BrowserAccessRules>();
+}
+
+QVariant BrowserEntryConfig::decodeAccessRules(const QString& settings)
+{
+    BrowserAccessRules rules;
+    BrowserEntryConfig config;
+    if (config.fromJson(settings)) {
+        rules.loaded = true;
+        rules.allowedHosts = config.m_allowedHosts;
+        rules.deniedHosts = config.m_deniedHosts;
+        rules.realm = config.m_realm;
+    }
+    return QVariant::fromValue(rules);
+}
+
 bool BrowserEntryConfig::load(const Entry* entry)
 {
-    QString s = entry->customData()->value(KEEPASSXCBROWSER_NAME);
+    return fromJson(entry->customData()->value(KEEPASSXCBROWSER_NAME));
+}
+
+bool BrowserEntryConfig::fromJson(const QString& s)
+{
     if (s.isEmpty()) {
         return false;
     }
@@ -24,9 +24,24 @@
 #include <QtCore/QSet>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QVariant>
 
 class Entry;
 
+/**
+ * Allow and deny lists of an entry in decoded form, see BrowserEntryConfig::accessRules()
+ */
+struct BrowserAccessRules
+{
+    // False if the entry has no KeePassXC-Browser settings
+    bool loaded = false;
+    QSet<QString> allowedHosts;
+    QSet<QString> deniedHosts;
+    QString realm;
+};
+
+Q_DECLARE_METATYPE(BrowserAccessRules)
+
 class BrowserEntryConfig : public QObject
 {
     Q_OBJECT
@@ -37,6 +52,8 @@ class BrowserEntryConfig : public QObject
 public:
     BrowserEntryConfig(QObject* object = nullptr);
 
+    static BrowserAccessRules accessRules(const Entry* entry);
+
     bool load(const Entry* entry);
     void save(Entry* entry);
     bool isAllowed(const QString& host) const;
@@ -47,6 +64,8 @@ public:
     void setRealm(const QString& realm);
 
 private:
+    static QVariant decodeAccessRules(const QString& settings);
+    bool fromJson(const QString& s);
     QStringList allowedHosts() const;
     void setAllowedHosts(const QStringList& allowedHosts);
     QStringList deniedHosts() const;
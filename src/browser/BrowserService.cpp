@@ -18,11 +18,9 @@
  */
 
 #include <QCheckBox>
-#include <QHostAddress>
 #include <QInputDialog>
 #include <QJsonArray>
 #include <QMessageBox>
-#include <QProgressDialog>
 #include <QUuid>
 
 #include "BrowserAccessControlDialog.h"
@@ -30,6 +28,7 @@
 #include "BrowserEntrySaveDialog.h"
 #include "BrowserService.h"
 #include "BrowserSettings.h"
+#include "BrowserUrlIndex.h"
 #include "core/Database.h"
 #include "core/EntrySearcher.h"
 #include "core/Group.h"
@@ -58,6 +57,65 @@ const QString BrowserService::OPTION_ONLY_HTTP_AUTH = QStringLiteral("BrowserOnl
 // Multiple URL's
 const QString BrowserService::ADDITIONAL_URL = QStringLiteral("KP2A_URL");
 
+namespace
+{
+    bool hasLegacySettings(const Entry* entry)
+    {
+        const EntryAttributes* attributes = entry->attributes();
+        return attributes->contains(KEEPASSHTTP_NAME) || attributes->contains(BrowserService::KEEPASSXCBROWSER_OLD_NAME)
+               || attributes->contains(BrowserService::KEEPASSXCBROWSER_NAME);
+    }
+
+    // Entries that only held the keys of KeePassHTTP and early KeePassXC-Browser versions
+    bool isLegacyKeyEntry(const Entry* entry)
+    {
+        return entry->title() == KEEPASSHTTP_NAME
+               || entry->title().contains(BrowserService::KEEPASSXCBROWSER_NAME, Qt::CaseInsensitive);
+    }
+
+    /**
+     * Position of an entry in the order of Group::entriesRecursive(), as the
+     * child indexes of its groups followed by its own index. Empty if the
+     * entry is not below root.
+     */
+    QVector<int> treePosition(Entry* entry, const Group* root)
+    {
+        const Group* group = entry->group();
+        if (!group) {
+            return {};
+        }
+
+        // Entries of a group come before the ones of its children
+        QVector<int> position = {-1, group->entries().indexOf(entry)};
+        for (; group != root; group = group->parentGroup()) {
+            const Group* parent = group->parentGroup();
+            if (!parent) {
+                return {};
+            }
+            position.prepend(parent->children().indexOf(const_cast<Group*>(group)));
+        }
+        return position;
+    }
+
+    void sortByTreePosition(QList<Entry*>& entries, const Group* root)
+    {
+        QList<QPair<QVector<int>, Entry*>> positions;
+        positions.reserve(entries.size());
+        for (Entry* entry : asConst(entries)) {
+            QVector<int> position = treePosition(entry, root);
+            if (!position.isEmpty()) {
+                positions.append({position, entry});
+            }
+        }
+        std::sort(positions.begin(), positions.end());
+
+        entries.clear();
+        for (const auto& position : asConst(positions)) {
+            entries.append(position.second);
+        }
+    }
+} // namespace
+
 BrowserService::BrowserService(DatabaseTabWidget* parent)
     : m_dbTabWidget(parent)
     , m_dialogActive(false)
@@ -79,6 +137,15 @@ BrowserService::BrowserService(DatabaseTabWidget* parent)
 
 bool BrowserService::isDatabaseOpened() const
 {
+    if (thread() != QThread::currentThread()) {
+        bool result = false;
+        QMetaObject::invokeMethod(const_cast<BrowserService*>(this),
+                                  "isDatabaseOpened",
+                                  Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(bool, result));
+        return result;
+    }
+
     DatabaseWidget* dbWidget = m_dbTabWidget->currentDatabaseWidget();
     if (!dbWidget) {
         return false;
@@ -90,6 +157,16 @@ bool BrowserService::isDatabaseOpened() const
 
 bool BrowserService::openDatabase(bool triggerUnlock)
 {
+    if (thread() != QThread::currentThread()) {
+        bool result = false;
+        QMetaObject::invokeMethod(this,
+                                  "openDatabase",
+                                  Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(bool, result),
+                                  Q_ARG(bool, triggerUnlock));
+        return result;
+    }
+
     if (!browserSettings()->unlockDatabase()) {
         return false;
     }
@@ -131,6 +208,15 @@ void BrowserService::lockDatabase()
 
 QString BrowserService::getDatabaseRootUuid()
 {
+    if (thread() != QThread::currentThread()) {
+        QString result;
+        QMetaObject::invokeMethod(this,
+                                  "getDatabaseRootUuid",
+                                  Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(QString, result));
+        return result;
+    }
+
     auto db = getDatabase();
     if (!db) {
         return {};
@@ -146,6 +232,15 @@ QString BrowserService::getDatabaseRootUuid()
 
 QString BrowserService::getDatabaseRecycleBinUuid()
 {
+    if (thread() != QThread::currentThread()) {
+        QString result;
+        QMetaObject::invokeMethod(this,
+                                  "getDatabaseRecycleBinUuid",
+                                  Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(QString, result));
+        return result;
+    }
+
     auto db = getDatabase();
     if (!db) {
         return {};
@@ -343,6 +438,16 @@ QString BrowserService::storeKey(const QString& key)
 
 QString BrowserService::getKey(const QString& id)
 {
+    if (thread() != QThread::currentThread()) {
+        QString result;
+        QMetaObject::invokeMethod(this,
+                                  "getKey",
+                                  Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(QString, result),
+                                  Q_ARG(QString, id));
+        return result;
+    }
+
     auto db = getDatabase();
     if (!db) {
         return {};
@@ -373,6 +478,58 @@ QJsonArray BrowserService::findMatchingEntries(const QString& id,
         return result;
     }
 
+    return prepareMatchingEntries(searchEntries(url, submitUrl, keyList), url, submitUrl, realm, httpAuth);
+}
+
+/**
+ * Answer several get-logins requests, e.g. one per frame of a page, in one go.
+ * Identical sites are only searched and confirmed once.
+ *
+ * @param requests objects with url, submitUrl and httpAuth members
+ * @return matching entries for each request, in the order of @p requests
+ */
+QJsonArray
+BrowserService::findMatchingEntriesBatch(const QString& id, const QJsonArray& requests, const StringPairList& keyList)
+{
+    QJsonArray result;
+    if (thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this,
+                                  "findMatchingEntriesBatch",
+                                  Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(QJsonArray, result),
+                                  Q_ARG(QString, id),
+                                  Q_ARG(QJsonArray, requests),
+                                  Q_ARG(StringPairList, keyList));
+        return result;
+    }
+
+    // Frames of the same site share one answer and at most one confirmation. Each site is searched right
+    // before it is prepared as a confirmation dialog may change or delete entries or lock the database.
+    QHash<QString, QJsonArray> answers;
+    for (const QJsonValue& value : requests) {
+        const QJsonObject request = value.toObject();
+        const QString url = request.value("url").toString();
+        const QString submitUrl = request.value("submitUrl").toString();
+        const bool httpAuth = request.value("httpAuth").toString() == TRUE_STR;
+        const QString key = QString("%1\n%2\n%3").arg(url, submitUrl, httpAuth ? TRUE_STR : FALSE_STR);
+
+        auto it = answers.constFind(key);
+        if (it == answers.constEnd()) {
+            const QList<Entry*> entries = url.isEmpty() ? QList<Entry*>() : searchEntries(url, submitUrl, keyList);
+            it = answers.insert(key, prepareMatchingEntries(entries, url, submitUrl, "", httpAuth));
+        }
+        result.append(it.value());
+    }
+
+    return result;
+}
+
+QJsonArray BrowserService::prepareMatchingEntries(const QList<Entry*>& entries,
+                                                  const QString& url,
+                                                  const QString& submitUrl,
+                                                  const QString& realm,
+                                                  const bool httpAuth)
+{
     const bool alwaysAllowAccess = browserSettings()->alwaysAllowAccess();
     const bool ignoreHttpAuth = browserSettings()->httpAuthPermission();
     const QString host = QUrl(url).host();
@@ -381,7 +538,7 @@ QJsonArray BrowserService::findMatchingEntries(const QString& id,
     // Check entries for authorization
     QList<Entry*> pwEntriesToConfirm;
     QList<Entry*> pwEntries;
-    for (auto* entry : searchEntries(url, submitUrl, keyList)) {
+    for (auto* entry : entries) {
         if (entry->customData()->contains(BrowserService::OPTION_HIDE_ENTRY)
             && entry->customData()->value(BrowserService::OPTION_HIDE_ENTRY) == TRUE_STR) {
             continue;
@@ -434,6 +591,7 @@ QJsonArray BrowserService::findMatchingEntries(const QString& id,
     pwEntries = sortEntries(pwEntries, host, submitUrl);
 
     // Fill the list
+    QJsonArray result;
     for (auto* entry : pwEntries) {
         result.append(prepareEntry(entry));
     }
@@ -597,36 +755,78 @@ BrowserService::searchEntries(const QSharedPointer<Database>& db, const QString&
         return entries;
     }
 
-    for (const auto& group : rootGroup->groupsRecursive(true)) {
-        if (group->isRecycled() || !group->resolveSearchingEnabled()) {
+    const SiteUrl site(url, submitUrl);
+    QList<Entry*> candidates;
+    if (url.contains("file://")) {
+        // Local files are matched by their full path, the index only knows hosts
+        candidates = rootGroup->entriesRecursive();
+    } else {
+        candidates = BrowserUrlIndex::forDatabase(db.data())->entries(site.baseDomain);
+        sortByTreePosition(candidates, rootGroup);
+    }
+
+    for (auto* entry : asConst(candidates)) {
+        const Group* group = entry->group();
+        if (group->isRecycled() || !group->resolveSearchingEnabled() || entry->isRecycled()) {
             continue;
         }
 
-        for (auto* entry : group->entries()) {
-            if (entry->isRecycled()) {
-                continue;
-            }
+        if (handleURL(entry->parsedUrl(), site)) {
+            entries.append(entry);
+            continue;
+        }
 
-            // Search for additional URL's starting with KP2A_URL
-            for (const auto& key : entry->attributes()->keys()) {
-                if (key.startsWith(ADDITIONAL_URL) && handleURL(entry->attributes()->value(key), url, submitUrl)) {
-                    entries.append(entry);
-                    continue;
-                }
+        // Search for additional URL's starting with KP2A_URL
+        for (const auto& key : entry->attributes()->customKeys()) {
+            if (key.startsWith(ADDITIONAL_URL) && handleURL(entry->parsedUrl(key), site)) {
+                entries.append(entry);
+                break;
             }
+        }
+    }
 
-            if (!handleURL(entry->url(), url, submitUrl)) {
-                continue;
-            }
+    return entries;
+}
 
-            entries.append(entry);
+/**
+ * Search entries for several sites at once, e.g. all frames of a page.
+ * Sites that appear more than once are only searched once.
+ *
+ * @param sites pairs of URL and submit URL
+ * @return matching entries for each site, in the order of @p sites
+ */
+QList<QList<Entry*>> BrowserService::searchEntries(const QSharedPointer<Database>& db, const StringPairList& sites)
+{
+    QList<QList<Entry*>> results;
+    QHash<StringPair, int> searched;
+    for (const StringPair& site : sites) {
+        auto it = searched.constFind(site);
+        if (it != searched.constEnd()) {
+            results.append(results.at(it.value()));
+            continue;
         }
+
+        searched.insert(site, results.size());
+        results.append(site.first.isEmpty() ? QList<Entry*>() : searchEntries(db, site.first, site.second));
+    }
+    return results;
+}
+
+QList<Entry*> BrowserService::searchEntries(const QString& url, const QString& submitUrl, const StringPairList& keyList)
+{
+    // Search entries matching the hostname
+    QList<Entry*> entries;
+    for (const auto& db : connectedDatabases(keyList)) {
+        entries << searchEntries(db, url, submitUrl);
     }
 
     return entries;
 }
 
-QList<Entry*> BrowserService::searchEntries(const QString& url, const QString& submitUrl, const StringPairList& keyList)
+/**
+ * @return the databases to search that are connected with one of the given keys
+ */
+QList<QSharedPointer<Database>> BrowserService::connectedDatabases(const StringPairList& keyList)
 {
     // Check if database is connected with KeePassXC-Browser
     auto databaseConnected = [&](const QSharedPointer<Database>& db) {
@@ -658,16 +858,7 @@ QList<Entry*> BrowserService::searchEntries(const QString& url, const QString& s
         }
     }
 
-    // Search entries matching the hostname
-    QString hostname = QUrl(url).host();
-    QList<Entry*> entries;
-    do {
-        for (const auto& db : databases) {
-            entries << searchEntries(db, url, submitUrl);
-        }
-    } while (entries.isEmpty() && removeFirstDomain(hostname));
-
-    return entries;
+    return databases;
 }
 
 void BrowserService::convertAttributesToCustomData(const QSharedPointer<Database>& currentDb)
@@ -677,37 +868,28 @@ void BrowserService::convertAttributesToCustomData(const QSharedPointer<Database
         return;
     }
 
-    QList<Entry*> entries = db->rootGroup()->entriesRecursive();
-    QProgressDialog progress(tr("Converting attributes to custom data…"), tr("Abort"), 0, entries.count());
-    progress.setWindowModality(Qt::WindowModal);
+    // Usually only a handful of entries carry legacy settings, find them before changing anything
+    QList<Entry*> legacyEntries;
+    for (Entry* entry : db->rootGroup()->entriesRecursive()) {
+        if (hasLegacySettings(entry) || isLegacyKeyEntry(entry)) {
+            legacyEntries.append(entry);
+        }
+    }
 
     int counter = 0;
     int keyCounter = 0;
-    for (auto* entry : entries) {
-        if (progress.wasCanceled()) {
-            return;
-        }
-
-        if (moveSettingsToCustomData(entry, KEEPASSHTTP_NAME)) {
-            ++counter;
-        }
-
-        if (moveSettingsToCustomData(entry, KEEPASSXCBROWSER_OLD_NAME)) {
-            ++counter;
-        }
-
-        if (moveSettingsToCustomData(entry, KEEPASSXCBROWSER_NAME)) {
-            ++counter;
-        }
-
-        if (entry->title() == KEEPASSHTTP_NAME || entry->title().contains(KEEPASSXCBROWSER_NAME, Qt::CaseInsensitive)) {
-            keyCounter += moveKeysToCustomData(entry, db);
-            delete entry;
+    {
+        // Views and listeners are notified once after all entries were converted
+        Database::BulkUpdate bulkUpdate(db.data());
+        for (Entry* entry : asConst(legacyEntries)) {
+            counter += moveSettingsToCustomData(entry);
+
+            if (isLegacyKeyEntry(entry)) {
+                keyCounter += moveKeysToCustomData(entry, db);
+                delete entry;
+            }
         }
-
-        progress.setValue(progress.value() + 1);
     }
-    progress.reset();
 
     if (counter > 0) {
         MessageBox::information(nullptr,
@@ -736,12 +918,15 @@ void BrowserService::convertAttributesToCustomData(const QSharedPointer<Database
         return;
     }
 
-    for (auto* g : rootGroup->groupsRecursive(true)) {
-        if (g->name() == KEEPASSHTTP_GROUP_NAME) {
-            g->setName(KEEPASSXCBROWSER_GROUP_NAME);
-            break;
-        }
-    }
+    rootGroup->walkGroups(
+        [](Group* g) {
+            if (g->name() == KEEPASSHTTP_GROUP_NAME) {
+                g->setName(KEEPASSXCBROWSER_GROUP_NAME);
+                return true;
+            }
+            return false;
+        },
+        true);
 }
 
 QList<Entry*> BrowserService::sortEntries(QList<Entry*>& pwEntries, const QString& host, const QString& entryUrl)
@@ -881,20 +1066,20 @@ QJsonObject BrowserService::prepareEntry(const Entry* entry)
 BrowserService::Access
 BrowserService::checkAccess(const Entry* entry, const QString& host, const QString& submitHost, const QString& realm)
 {
-    BrowserEntryConfig config;
-    if (!config.load(entry)) {
+    const BrowserAccessRules rules = BrowserEntryConfig::accessRules(entry);
+    if (!rules.loaded) {
         return Unknown;
     }
     if (entry->isExpired()) {
         return browserSettings()->allowExpiredCredentials() ? Allowed : Denied;
     }
-    if ((config.isAllowed(host)) && (submitHost.isEmpty() || config.isAllowed(submitHost))) {
+    if ((rules.allowedHosts.contains(host)) && (submitHost.isEmpty() || rules.allowedHosts.contains(submitHost))) {
         return Allowed;
     }
-    if ((config.isDenied(host)) || (!submitHost.isEmpty() && config.isDenied(submitHost))) {
+    if ((rules.deniedHosts.contains(host)) || (!submitHost.isEmpty() && rules.deniedHosts.contains(submitHost))) {
         return Denied;
     }
-    if (!realm.isEmpty() && config.realm() != realm) {
+    if (!realm.isEmpty() && rules.realm != realm) {
         return Denied;
     }
     return Unknown;
@@ -912,10 +1097,18 @@ Group* BrowserService::getDefaultEntryGroup(const QSharedPointer<Database>& sele
         return nullptr;
     }
 
-    for (auto* g : rootGroup->groupsRecursive(true)) {
-        if (g->name() == KEEPASSXCBROWSER_GROUP_NAME && !g->isRecycled()) {
-            return db->rootGroup()->findGroupByUuid(g->uuid());
-        }
+    Group* browserGroup = nullptr;
+    rootGroup->walkGroups(
+        [&browserGroup](Group* g) {
+            if (g->name() == KEEPASSXCBROWSER_GROUP_NAME && !g->isRecycled()) {
+                browserGroup = g;
+                return true;
+            }
+            return false;
+        },
+        true);
+    if (browserGroup) {
+        return browserGroup;
     }
 
     auto* group = new Group();
@@ -931,21 +1124,11 @@ int BrowserService::sortPriority(const Entry* entry,
                                  const QString& submitUrl,
                                  const QString& baseSubmitUrl) const
 {
-    QUrl url(entry->url());
-    if (url.scheme().isEmpty()) {
-        url.setScheme("https");
-    }
-
-    // Add the empty path to the URL if it's missing
-    if (url.path().isEmpty() && !url.hasFragment() && !url.hasQuery()) {
-        url.setPath("/");
-    }
-
-    const QString entryURL = url.toString(QUrl::StripTrailingSlash);
-    const QString baseEntryURL =
-        url.toString(QUrl::StripTrailingSlash | QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment);
+    const EntryUrl url = entry->parsedUrl();
+    const QString& entryURL = url.normalized;
+    const QString& baseEntryURL = url.normalizedBase;
 
-    if (!url.host().contains(".") && url.host() != "localhost") {
+    if (!url.normalizedHost.contains(".") && url.normalizedHost != "localhost") {
         return 0;
     }
     if (submitUrl == entryURL) {
@@ -990,75 +1173,62 @@ bool BrowserService::schemeFound(const QString& url)
     return !address.scheme().isEmpty();
 }
 
-bool BrowserService::removeFirstDomain(QString& hostname)
+BrowserService::SiteUrl::SiteUrl(const QString& url, const QString& submitUrl)
+    : url(url)
+    , submitUrl(submitUrl)
+    , qurl(url)
+    , baseDomain(BrowserService::baseDomain(qurl.host()))
+    , matchScheme(browserSettings()->matchUrlScheme())
 {
-    int pos = hostname.indexOf(".");
-    if (pos < 0) {
-        return false;
-    }
-
-    // Don't remove the second-level domain if it's the only one
-    if (hostname.count(".") > 1) {
-        hostname = hostname.mid(pos + 1);
-        return !hostname.isEmpty();
-    }
-
-    // Nothing removed
-    return false;
 }
 
 bool BrowserService::handleURL(const QString& entryUrl, const QString& url, const QString& submitUrl)
 {
-    if (entryUrl.isEmpty()) {
-        return false;
-    }
-
-    QUrl entryQUrl;
-    if (entryUrl.contains("://")) {
-        entryQUrl = entryUrl;
-    } else {
-        entryQUrl = QUrl::fromUserInput(entryUrl);
+    return handleURL(EntryUrl::parse(entryUrl), SiteUrl(url, submitUrl));
+}
 
-        if (browserSettings()->matchUrlScheme()) {
-            entryQUrl.setScheme("https");
-        }
+bool BrowserService::handleURL(const EntryUrl& entryUrl, const SiteUrl& site)
+{
+    if (entryUrl.raw.isEmpty()) {
+        return false;
     }
 
     // Make a direct compare if a local file is used
-    if (url.contains("file://")) {
-        return entryUrl == submitUrl;
+    if (site.url.contains("file://")) {
+        return entryUrl.raw == site.submitUrl;
     }
 
     // URL host validation fails
-    if (entryQUrl.host().isEmpty()) {
+    if (entryUrl.host.isEmpty()) {
         return false;
     }
 
     // Match port, if used
-    QUrl siteQUrl(url);
-    if (entryQUrl.port() > 0 && entryQUrl.port() != siteQUrl.port()) {
+    if (entryUrl.port > 0 && entryUrl.port != site.qurl.port()) {
         return false;
     }
 
-    // Match scheme
-    if (browserSettings()->matchUrlScheme() && !entryQUrl.scheme().isEmpty()
-        && entryQUrl.scheme().compare(siteQUrl.scheme()) != 0) {
-        return false;
+    // Match scheme, URLs without one are treated as https
+    if (site.matchScheme) {
+        const QString scheme = entryUrl.hasScheme ? entryUrl.url.scheme() : QStringLiteral("https");
+        if (!scheme.isEmpty() && scheme.compare(site.qurl.scheme()) != 0) {
+            return false;
+        }
     }
 
     // Check for illegal characters
-    QRegularExpression re("[<>\\^`{|}]");
-    if (re.match(entryUrl).hasMatch()) {
+    static const QRegularExpression re("[<>\\^`{|}]");
+    if (re.match(entryUrl.raw).hasMatch()) {
         return false;
     }
 
     // Match the base domain
-    if (baseDomain(siteQUrl.host()) != baseDomain(entryQUrl.host())) {
+    if (site.baseDomain != entryUrl.baseDomain) {
         return false;
     }
 
     // Match the subdomains with the limited wildcard
-    if (siteQUrl.host().endsWith(entryQUrl.host())) {
+    if (site.qurl.host().endsWith(entryUrl.host)) {
         return true;
     }
 
@@ -1070,28 +1240,9 @@ bool BrowserService::handleURL(const QString& entryUrl, const QString& url, cons
  *
  * Returns the base domain, e.g. https://another.example.co.uk -> example.co.uk
  */
-QString BrowserService::baseDomain(const QString& hostname) const
+QString BrowserService::baseDomain(const QString& hostname)
 {
-    QUrl qurl = QUrl::fromUserInput(hostname);
-    QString host = qurl.host();
-
-    // If the hostname is an IP address, return it directly
-    QHostAddress hostAddress(hostname);
-    if (!hostAddress.isNull()) {
-        return hostname;
-    }
-
-    if (host.isEmpty() || !host.contains(qurl.topLevelDomain())) {
-        return {};
-    }
-
-    // Remove the top level domain part from the hostname, e.g. https://another.example.co.uk -> https://another.example
-    host.chop(qurl.topLevelDomain().length());
-    // Split the URL and select the last part, e.g. https://another.example -> example
-    QString baseDomain = host.split('.').last();
-    // Append the top level domain back to the URL, e.g. example -> example.co.uk
-    baseDomain.append(qurl.topLevelDomain());
-    return baseDomain;
+    return Tools::baseDomain(hostname);
 }
 
 QSharedPointer<Database> BrowserService::getDatabase()
@@ -1140,19 +1291,33 @@ QSharedPointer<Database> BrowserService::selectedDatabase()
     return getDatabase();
 }
 
-bool BrowserService::moveSettingsToCustomData(Entry* entry, const QString& name) const
+/**
+ * Move the settings of all legacy attributes of an entry to custom data
+ * in a single update.
+ *
+ * @return number of attributes that were moved
+ */
+int BrowserService::moveSettingsToCustomData(Entry* entry) const
 {
-    if (entry->attributes()->contains(name)) {
-        QString attr = entry->attributes()->value(name);
-        entry->beginUpdate();
-        if (!attr.isEmpty()) {
-            entry->customData()->set(KEEPASSXCBROWSER_NAME, attr);
+    if (!hasLegacySettings(entry)) {
+        return 0;
+    }
+
+    int moved = 0;
+    entry->beginUpdate();
+    // Later names take precedence, like the attributes were converted one after another
+    for (const QString& name : {KEEPASSHTTP_NAME, KEEPASSXCBROWSER_OLD_NAME, KEEPASSXCBROWSER_NAME}) {
+        if (entry->attributes()->contains(name)) {
+            QString attr = entry->attributes()->value(name);
+            if (!attr.isEmpty()) {
+                entry->customData()->set(KEEPASSXCBROWSER_NAME, attr);
+            }
+            entry->attributes()->remove(name);
+            ++moved;
         }
-        entry->attributes()->remove(name);
-        entry->endUpdate();
-        return true;
     }
-    return false;
+    entry->endUpdate();
+    return moved;
 }
 
 int BrowserService::moveKeysToCustomData(Entry* entry, const QSharedPointer<Database>& db) const
@@ -1185,15 +1350,10 @@ bool BrowserService::checkLegacySettings()
         return false;
     }
 
-    bool legacySettingsFound = false;
-    QList<Entry*> entries = db->rootGroup()->entriesRecursive();
-    for (const auto& e : entries) {
-        if ((e->attributes()->contains(KEEPASSHTTP_NAME) || e->attributes()->contains(KEEPASSXCBROWSER_NAME))
-            || (e->title() == KEEPASSHTTP_NAME || e->title().contains(KEEPASSXCBROWSER_NAME, Qt::CaseInsensitive))) {
-            legacySettingsFound = true;
-            break;
-        }
-    }
+    const bool legacySettingsFound = db->rootGroup()->walkEntries([](const Entry* e) {
+        return (e->attributes()->contains(KEEPASSHTTP_NAME) || e->attributes()->contains(KEEPASSXCBROWSER_NAME))
+               || (e->title() == KEEPASSHTTP_NAME || e->title().contains(KEEPASSXCBROWSER_NAME, Qt::CaseInsensitive));
+    });
 
     if (!legacySettingsFound) {
         return false;
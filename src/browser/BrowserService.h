@@ -47,13 +47,13 @@ public:
 
     explicit BrowserService(DatabaseTabWidget* parent);
 
-    bool isDatabaseOpened() const;
-    bool openDatabase(bool triggerUnlock);
-    QString getDatabaseRootUuid();
-    QString getDatabaseRecycleBinUuid();
+    Q_INVOKABLE bool isDatabaseOpened() const;
+    Q_INVOKABLE bool openDatabase(bool triggerUnlock);
+    Q_INVOKABLE QString getDatabaseRootUuid();
+    Q_INVOKABLE QString getDatabaseRecycleBinUuid();
     QJsonObject getDatabaseGroups(const QSharedPointer<Database>& selectedDb = {});
     QJsonObject createNewGroup(const QString& groupName);
-    QString getKey(const QString& id);
+    Q_INVOKABLE QString getKey(const QString& id);
     void addEntry(const QString& id,
                   const QString& login,
                   const QString& password,
@@ -65,8 +65,11 @@ public:
                   const QSharedPointer<Database>& selectedDb = {});
     QList<Entry*> searchEntries(const QSharedPointer<Database>& db, const QString& url, const QString& submitUrl);
     QList<Entry*> searchEntries(const QString& url, const QString& submitUrl, const StringPairList& keyList);
+    QList<QList<Entry*>> searchEntries(const QSharedPointer<Database>& db, const StringPairList& sites);
     void convertAttributesToCustomData(const QSharedPointer<Database>& currentDb = {});
 
+    static QString baseDomain(const QString& hostname);
+
 public:
     static const QString KEEPASSXCBROWSER_NAME;
     static const QString KEEPASSXCBROWSER_OLD_NAME;
@@ -84,6 +87,8 @@ public slots:
                                    const QString& realm,
                                    const StringPairList& keyList,
                                    const bool httpAuth = false);
+    QJsonArray
+    findMatchingEntriesBatch(const QString& id, const QJsonArray& requests, const StringPairList& keyList);
     QString storeKey(const QString& key);
     ReturnValue updateEntry(const QString& id,
                             const QString& uuid,
@@ -116,7 +121,25 @@ private:
         Hidden
     };
 
+    // Site of a request, parsed once and matched against many entry URLs
+    struct SiteUrl
+    {
+        SiteUrl(const QString& url, const QString& submitUrl);
+
+        QString url;
+        QString submitUrl;
+        QUrl qurl;
+        QString baseDomain;
+        bool matchScheme;
+    };
+
 private:
+    QList<QSharedPointer<Database>> connectedDatabases(const StringPairList& keyList);
+    QJsonArray prepareMatchingEntries(const QList<Entry*>& entries,
+                                      const QString& url,
+                                      const QString& submitUrl,
+                                      const QString& realm,
+                                      const bool httpAuth);
     QList<Entry*> sortEntries(QList<Entry*>& pwEntries, const QString& host, const QString& submitUrl);
     bool confirmEntries(QList<Entry*>& pwEntriesToConfirm,
                         const QString& url,
@@ -130,13 +153,12 @@ private:
     int
     sortPriority(const Entry* entry, const QString& host, const QString& submitUrl, const QString& baseSubmitUrl) const;
     bool schemeFound(const QString& url);
-    bool removeFirstDomain(QString& hostname);
     bool handleURL(const QString& entryUrl, const QString& url, const QString& submitUrl);
-    QString baseDomain(const QString& hostname) const;
+    bool handleURL(const EntryUrl& entryUrl, const SiteUrl& site);
     QSharedPointer<Database> getDatabase();
     QSharedPointer<Database> selectedDatabase();
     QJsonArray getChildrenFromGroup(Group* group);
-    bool moveSettingsToCustomData(Entry* entry, const QString& name) const;
+    int moveSettingsToCustomData(Entry* entry) const;
     int moveKeysToCustomData(Entry* entry, const QSharedPointer<Database>& db) const;
     bool checkLegacySettings();
     void hideWindow() const;
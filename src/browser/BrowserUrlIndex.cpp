@@ -0,0 +1,129 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BrowserUrlIndex.h"
+
+#include "BrowserService.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Global.h"
+#include "core/Group.h"
+
+BrowserUrlIndex::BrowserUrlIndex(Database* db)
+    : QObject(db)
+{
+    connect(db, &Database::entryAdded, this, &BrowserUrlIndex::addEntry);
+    connect(db, &Database::entryRemoved, this, &BrowserUrlIndex::removeEntry);
+
+    if (db->rootGroup()) {
+        for (Entry* entry : db->rootGroup()->entriesRecursive()) {
+            addEntry(entry);
+        }
+    }
+}
+
+/**
+ * @return the index of the database, built on the first call
+ */
+BrowserUrlIndex* BrowserUrlIndex::forDatabase(Database* db)
+{
+    auto* index = db->findChild<BrowserUrlIndex*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!index) {
+        index = new BrowserUrlIndex(db);
+    }
+    return index;
+}
+
+/**
+ * @param domain base domain as returned by BrowserService::baseDomain()
+ * @return entries with at least one URL on the given base domain, in no particular order
+ */
+QList<Entry*> BrowserUrlIndex::entries(const QString& domain) const
+{
+    return m_entries.value(domain).values();
+}
+
+void BrowserUrlIndex::addEntry(Entry* entry)
+{
+    if (m_indexedUrls.contains(entry)) {
+        return;
+    }
+
+    connect(entry, &Entry::entryModified, this, [this, entry]() { updateEntry(entry); });
+    indexEntry(entry, entryUrls(entry));
+}
+
+void BrowserUrlIndex::removeEntry(Entry* entry)
+{
+    entry->disconnect(this);
+    unindexEntry(entry);
+}
+
+void BrowserUrlIndex::updateEntry(Entry* entry)
+{
+    QStringList urls = entryUrls(entry);
+    auto it = m_indexedUrls.constFind(entry);
+    if (it != m_indexedUrls.constEnd() && it->urls == urls) {
+        return;
+    }
+
+    unindexEntry(entry);
+    indexEntry(entry, urls);
+}
+
+void BrowserUrlIndex::indexEntry(Entry* entry, const QStringList& urls)
+{
+    IndexedUrls indexed;
+    indexed.urls = urls;
+    for (const QString& url : urls) {
+        // URLs without a host never match a site, see BrowserService::handleURL()
+        const EntryUrl parsed = EntryUrl::parse(url);
+        if (!parsed.host.isEmpty()) {
+            indexed.domains.insert(parsed.baseDomain);
+            m_entries[parsed.baseDomain].insert(entry);
+        }
+    }
+    m_indexedUrls.insert(entry, indexed);
+}
+
+void BrowserUrlIndex::unindexEntry(Entry* entry)
+{
+    auto it = m_indexedUrls.find(entry);
+    if (it == m_indexedUrls.end()) {
+        return;
+    }
+
+    for (const QString& domain : asConst(it->domains)) {
+        auto entries = m_entries.find(domain);
+        entries->remove(entry);
+        if (entries->isEmpty()) {
+            m_entries.erase(entries);
+        }
+    }
+    m_indexedUrls.erase(it);
+}
+
+QStringList BrowserUrlIndex::entryUrls(const Entry* entry)
+{
+    QStringList urls = {entry->url()};
+    for (const QString& key : entry->attributes()->customKeys()) {
+        if (key.startsWith(BrowserService::ADDITIONAL_URL)) {
+            urls.append(entry->attributes()->value(key));
+        }
+    }
+    return urls;
+}
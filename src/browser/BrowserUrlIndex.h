@@ -0,0 +1,68 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BROWSERURLINDEX_H
+#define BROWSERURLINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class Database;
+class Entry;
+
+/**
+ * Maps the base domain of every entry URL, including additional URLs,
+ * to the entries of a database.
+ *
+ * The index is created on first use, lives as long as its database and
+ * follows entries as they are added, modified and removed. Lookups only
+ * narrow down the candidates, callers still have to match the full URL.
+ */
+class BrowserUrlIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static BrowserUrlIndex* forDatabase(Database* db);
+
+    QList<Entry*> entries(const QString& domain) const;
+
+private:
+    explicit BrowserUrlIndex(Database* db);
+
+    void addEntry(Entry* entry);
+    void removeEntry(Entry* entry);
+    void updateEntry(Entry* entry);
+    void indexEntry(Entry* entry, const QStringList& urls);
+    void unindexEntry(Entry* entry);
+
+    static QStringList entryUrls(const Entry* entry);
+
+    struct IndexedUrls
+    {
+        // Kept to skip modifications that leave the URLs unchanged
+        QStringList urls;
+        QSet<QString> domains;
+    };
+
+    QHash<Entry*, IndexedUrls> m_indexedUrls;
+    QHash<QString, QSet<Entry*>> m_entries;
+};
+
+#endif // BROWSERURLINDEX_H
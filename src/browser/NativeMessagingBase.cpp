@@ -18,25 +18,63 @@
 
 #include "NativeMessagingBase.h"
 #include <QStandardPaths>
+#include <QThread>
+#include <QtEndian>
 
 #include "config-keepassx.h"
 
-#if defined(Q_OS_UNIX) && !defined(Q_OS_LINUX)
-#include <sys/event.h>
-#include <sys/time.h>
-#include <sys/types.h>
-#include <unistd.h>
-#endif
+#include <cstring>
 
-#ifdef Q_OS_LINUX
-#include <sys/epoll.h>
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
 #include <unistd.h>
 #endif
 
+namespace
+{
+    // Native messaging frames start with the payload length in native byte order
+    const int FrameHeaderSize = sizeof(quint32);
+    const int ReadChunkSize = 64 * 1024;
+
 #ifdef Q_OS_WIN
-#include <fcntl.h>
-#include <io.h>
+    /**
+     * Read exactly @p size bytes from stdin without blocking in ReadFile,
+     * so that the reader notices when it is stopped while the browser is idle.
+     *
+     * @return false if reading was stopped or the pipe was closed
+     */
+    bool readStdIn(const QAtomicInt& running, char* data, DWORD size)
+    {
+        HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+        while (size > 0) {
+            if (running.load() == 0) {
+                return false;
+            }
+
+            DWORD available = 0;
+            if (!PeekNamedPipe(input, nullptr, 0, nullptr, &available, nullptr)) {
+                return false;
+            }
+            if (available == 0) {
+                QThread::msleep(10);
+                continue;
+            }
+
+            DWORD bytesRead = 0;
+            if (!ReadFile(input, data, qMin(available, size), &bytesRead, nullptr) || bytesRead == 0) {
+                return false;
+            }
+            data += bytesRead;
+            size -= bytesRead;
+        }
+        return true;
+    }
 #endif
+} // namespace
 
 NativeMessagingBase::NativeMessagingBase(const bool enabled)
 {
@@ -52,88 +90,181 @@ NativeMessagingBase::NativeMessagingBase(const bool enabled)
 #endif
 }
 
+/**
+ * Read whatever is available on stdin and dispatch every complete frame.
+ *
+ * Called by the socket notifier, so the read never blocks. Partial frames
+ * stay buffered until the notifier fires again with the rest of the data.
+ */
 void NativeMessagingBase::newNativeMessage()
 {
-#if defined(Q_OS_UNIX) && !defined(Q_OS_LINUX)
-    struct kevent ev[1];
-    struct timespec ts = {5, 0};
+#ifndef Q_OS_WIN
+    const int oldSize = m_inputBuffer.size();
+    m_inputBuffer.resize(oldSize + ReadChunkSize);
+    const ssize_t bytesRead = ::read(fileno(stdin), m_inputBuffer.data() + oldSize, ReadChunkSize);
+    m_inputBuffer.resize(oldSize + qMax<ssize_t>(bytesRead, 0));
 
-    int fd = kqueue();
-    if (fd == -1) {
-        m_notifier->setEnabled(false);
+    if (bytesRead < 0 && (errno == EINTR || errno == EAGAIN)) {
         return;
     }
-
-    EV_SET(ev, fileno(stdin), EVFILT_READ, EV_ADD, 0, 0, nullptr);
-    if (kevent(fd, ev, 1, nullptr, 0, &ts) == -1) {
-        m_notifier->setEnabled(false);
-        ::close(fd);
+    if (bytesRead <= 0) {
+        closeNativeInput();
         return;
     }
 
-    int ret = kevent(fd, NULL, 0, ev, 1, &ts);
-    if (ret < 1) {
-        m_notifier->setEnabled(false);
-        ::close(fd);
-        return;
-    }
-#elif defined(Q_OS_LINUX)
-    int fd = epoll_create(5);
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.fd = 0;
-    if (epoll_ctl(fd, EPOLL_CTL_ADD, 0, &event) != 0) {
-        m_notifier->setEnabled(false);
-        ::close(fd);
-        return;
+    processNativeInput();
+#endif
+}
+
+void NativeMessagingBase::processNativeInput()
+{
+    while (m_inputBuffer.size() >= FrameHeaderSize) {
+        quint32 length = 0;
+        memcpy(&length, m_inputBuffer.constData(), FrameHeaderSize);
+        // Oversized frames would be buffered forever without ever completing
+        if (length == 0 || length > static_cast<quint32>(NATIVE_MSG_MAX_LENGTH)) {
+            m_inputBuffer.clear();
+            closeNativeInput();
+            return;
+        }
+        if (static_cast<quint32>(m_inputBuffer.size() - FrameHeaderSize) < length) {
+            break;
+        }
+
+        // Taken out of the buffer first, a handler that opens a dialog lets newNativeMessage() run again
+        const QByteArray message = m_inputBuffer.mid(FrameHeaderSize, static_cast<int>(length));
+        m_inputBuffer.remove(0, FrameHeaderSize + static_cast<int>(length));
+        handleNativeMessage(message);
     }
+}
 
-    if (epoll_wait(fd, &event, 1, 5000) < 1) {
+/**
+ * Stop listening on stdin, called once the browser closes the pipe
+ * or sends an empty or oversized frame.
+ */
+void NativeMessagingBase::closeNativeInput()
+{
+    if (m_notifier) {
         m_notifier->setEnabled(false);
-        ::close(fd);
-        return;
     }
-#endif
-    readLength();
-#ifndef Q_OS_WIN
-    ::close(fd);
-#endif
 }
 
+/**
+ * Reader loop used on Windows, where stdin cannot be watched by a socket
+ * notifier. Runs on a worker thread until a full frame is available, then
+ * hands it over to the object's thread. Stops once m_running is cleared.
+ */
 void NativeMessagingBase::readNativeMessages()
 {
 #ifdef Q_OS_WIN
-    quint32 length = 0;
-    while (m_running.load() != 0 && !std::cin.eof()) {
-        length = 0;
-        std::cin.readsome(reinterpret_cast<char*>(&length), 4);
-        readStdIn(length);
-        QThread::msleep(100);
+    while (m_running.load() != 0) {
+        quint32 length = 0;
+        if (!readStdIn(m_running, reinterpret_cast<char*>(&length), FrameHeaderSize) || length == 0
+            || length > static_cast<quint32>(NATIVE_MSG_MAX_LENGTH)) {
+            break;
+        }
+
+        QByteArray message(static_cast<int>(length), '\0');
+        if (!readStdIn(m_running, message.data(), length)) {
+            // message ended prematurely, ignore it
+            break;
+        }
+        QMetaObject::invokeMethod(this, "handleNativeMessage", Qt::QueuedConnection, Q_ARG(QByteArray, message));
     }
+    QMetaObject::invokeMethod(this, "closeNativeInput", Qt::QueuedConnection);
 #endif
 }
 
-QString NativeMessagingBase::jsonToString(const QJsonObject& json) const
+/**
+ * Sent once by keepassxc-proxy after connecting to announce framed messages.
+ * Older proxies send bare JSON messages, which never start with this.
+ */
+QByteArray NativeMessagingBase::proxyProtocolMagic()
+{
+    return QByteArrayLiteral("KPXCMUX1");
+}
+
+QByteArray NativeMessagingBase::buildProxyFrame(quint32 requestId, const QByteArray& payload)
+{
+    QByteArray frame(PROXY_FRAME_HEADER_LENGTH, Qt::Uninitialized);
+    auto* header = reinterpret_cast<uchar*>(frame.data());
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), header);
+    qToLittleEndian<quint32>(requestId, header + sizeof(quint32));
+    return frame.append(payload);
+}
+
+/**
+ * Take the next complete frame from the device's read buffer.
+ *
+ * Incomplete frames are left in place, so callers simply try again
+ * on the next readyRead() without buffering anything themselves.
+ *
+ * A header announcing more than NATIVE_MSG_MAX_LENGTH bytes can never
+ * complete within the socket read buffer. In that case @p ok is set to
+ * false and the caller should close the connection.
+ *
+ * @return true if a frame was read
+ */
+bool NativeMessagingBase::readProxyFrame(QIODevice* device, quint32* requestId, QByteArray* payload, bool* ok)
+{
+    if (ok) {
+        *ok = true;
+    }
+
+    if (device->bytesAvailable() < PROXY_FRAME_HEADER_LENGTH) {
+        return false;
+    }
+
+    const QByteArray header = device->peek(PROXY_FRAME_HEADER_LENGTH);
+    const auto* data = reinterpret_cast<const uchar*>(header.constData());
+    const quint32 length = qFromLittleEndian<quint32>(data);
+    if (length > static_cast<quint32>(NATIVE_MSG_MAX_LENGTH)) {
+        if (ok) {
+            *ok = false;
+        }
+        return false;
+    }
+
+    if (device->bytesAvailable() - PROXY_FRAME_HEADER_LENGTH < length) {
+        return false;
+    }
+
+    *requestId = qFromLittleEndian<quint32>(data + sizeof(quint32));
+    device->read(PROXY_FRAME_HEADER_LENGTH);
+    *payload = device->read(length);
+    return true;
+}
+
+QByteArray NativeMessagingBase::jsonToUtf8(const QJsonObject& json)
 {
-    return QString(QJsonDocument(json).toJson(QJsonDocument::Compact));
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
 }
 
 void NativeMessagingBase::sendReply(const QJsonObject& json)
 {
     if (!json.isEmpty()) {
-        sendReply(jsonToString(json));
+        sendReply(jsonToUtf8(json));
     }
 }
 
-void NativeMessagingBase::sendReply(const QString& reply)
+/**
+ * Write a reply to the browser. The length prefix and the payload are put
+ * into one buffer, which keeps its capacity between replies, and written
+ * with a single call.
+ */
+void NativeMessagingBase::sendReply(const QByteArray& reply)
 {
-    if (!reply.isEmpty()) {
-        QByteArray bytes = reply.toUtf8();
-        uint len = bytes.size();
-        std::cout << char(((len >> 0) & 0xFF)) << char(((len >> 8) & 0xFF)) << char(((len >> 16) & 0xFF))
-                  << char(((len >> 24) & 0xFF));
-        std::cout << reply.toStdString() << std::flush;
+    if (reply.isEmpty()) {
+        return;
     }
+
+    const quint32 length = static_cast<quint32>(reply.size());
+    m_outputBuffer.resize(FrameHeaderSize);
+    memcpy(m_outputBuffer.data(), &length, FrameHeaderSize);
+    m_outputBuffer.append(reply);
+
+    std::cout.write(m_outputBuffer.constData(), m_outputBuffer.size());
+    std::cout.flush();
 }
 
 QString NativeMessagingBase::getLocalServerPath() const
@@ -150,3 +281,13 @@ QString NativeMessagingBase::getLocalServerPath() const
     return QStandardPaths::writableLocation(QStandardPaths::TempLocation) + serverPath;
 #endif
 }
+
+/**
+ * Framed messages are served on their own path. Older KeePassXC versions
+ * only listen on getLocalServerPath(), which lets a newer proxy notice them
+ * and fall back to bare messages.
+ */
+QString NativeMessagingBase::getFramedServerPath() const
+{
+    return getLocalServerPath() + "_framed";
+}
@@ -38,6 +38,8 @@
 #endif
 
 static const int NATIVE_MSG_MAX_LENGTH = 1024 * 1024;
+// Frames between keepassxc-proxy and KeePassXC start with the payload length and a request ID
+static const int PROXY_FRAME_HEADER_LENGTH = 2 * sizeof(quint32);
 
 class NativeMessagingBase : public QObject
 {
@@ -47,22 +49,33 @@ public:
     explicit NativeMessagingBase(const bool enabled);
     ~NativeMessagingBase() = default;
 
+    static QByteArray proxyProtocolMagic();
+    static QByteArray buildProxyFrame(quint32 requestId, const QByteArray& payload);
+    static bool readProxyFrame(QIODevice* device, quint32* requestId, QByteArray* payload, bool* ok = nullptr);
+
 protected slots:
     void newNativeMessage();
+    virtual void handleNativeMessage(const QByteArray& message) = 0;
+    virtual void closeNativeInput();
 
 protected:
-    virtual void readLength() = 0;
-    virtual bool readStdIn(const quint32 length) = 0;
-    virtual void readNativeMessages();
-    QString jsonToString(const QJsonObject& json) const;
+    void readNativeMessages();
+    static QByteArray jsonToUtf8(const QJsonObject& json);
     void sendReply(const QJsonObject& json);
-    void sendReply(const QString& reply);
+    void sendReply(const QByteArray& reply);
     QString getLocalServerPath() const;
+    QString getFramedServerPath() const;
 
 protected:
     QAtomicInt m_running;
     QSharedPointer<QSocketNotifier> m_notifier;
     QFuture<void> m_future;
+
+private:
+    void processNativeInput();
+
+    QByteArray m_inputBuffer;
+    QByteArray m_outputBuffer;
 };
 
 #endif // NATIVEMESSAGINGBASE_H
@@ -19,6 +19,7 @@
 #include "NativeMessagingHost.h"
 #include "BrowserSettings.h"
 #include "sodium.h"
+#include <QFutureWatcher>
 #include <QMutexLocker>
 #include <QtNetwork>
 #include <iostream>
@@ -35,6 +36,8 @@ NativeMessagingHost::NativeMessagingHost(DatabaseTabWidget* parent, const bool e
 {
     m_localServer.reset(new QLocalServer(this));
     m_localServer->setSocketOptions(QLocalServer::UserAccessOption);
+    m_framedServer.reset(new QLocalServer(this));
+    m_framedServer->setSocketOptions(QLocalServer::UserAccessOption);
     m_running.store(0);
 
     if (browserSettings()->isEnabled() && m_running.load() == 0) {
@@ -70,14 +73,12 @@ void NativeMessagingHost::run()
     }
 
     m_running.store(1);
-#ifdef Q_OS_WIN
-    m_future =
-        QtConcurrent::run(this, static_cast<void (NativeMessagingHost::*)()>(&NativeMessagingHost::readNativeMessages));
-#endif
 
     if (browserSettings()->supportBrowserProxy()) {
         QString serverPath = getLocalServerPath();
+        QString framedServerPath = getFramedServerPath();
         QFile::remove(serverPath);
+        QFile::remove(framedServerPath);
 
         // Ensure that STDIN is not being listened when proxy is used
         if (m_notifier && m_notifier->isEnabled()) {
@@ -87,64 +88,55 @@ void NativeMessagingHost::run()
         if (m_localServer->isListening()) {
             m_localServer->close();
         }
+        if (m_framedServer->isListening()) {
+            m_framedServer->close();
+        }
 
+        // Older proxies connect to the legacy path, newer ones try the framed path first
         m_localServer->listen(serverPath);
+        m_framedServer->listen(framedServerPath);
         connect(m_localServer.data(), SIGNAL(newConnection()), this, SLOT(newLocalConnection()));
+        connect(m_framedServer.data(), SIGNAL(newConnection()), this, SLOT(newLocalConnection()));
     } else {
         m_localServer->close();
+        m_framedServer->close();
+#ifdef Q_OS_WIN
+        // The reader blocks on STDIN, only start it when the browser talks to us directly
+        if (!m_future.isRunning()) {
+            m_future = QtConcurrent::run(
+                this, static_cast<void (NativeMessagingHost::*)()>(&NativeMessagingHost::readNativeMessages));
+        }
+#endif
     }
 }
 
 void NativeMessagingHost::stop()
 {
+    // Pending requests may still be waiting for the GUI thread
+    while (!m_requestPool.waitForDone(10)) {
+        QCoreApplication::processEvents();
+    }
+
     databaseLocked();
     QMutexLocker locker(&m_mutex);
     m_socketList.clear();
+    m_pendingRequests.clear();
     m_running.testAndSetOrdered(1, 0);
     m_future.waitForFinished();
     m_localServer->close();
+    m_framedServer->close();
 }
 
-void NativeMessagingHost::readLength()
-{
-    quint32 length = 0;
-    std::cin.read(reinterpret_cast<char*>(&length), 4);
-    if (!std::cin.eof() && length > 0) {
-        readStdIn(length);
-    } else {
-        m_notifier->setEnabled(false);
-    }
-}
-
-bool NativeMessagingHost::readStdIn(const quint32 length)
+void NativeMessagingHost::handleNativeMessage(const QByteArray& message)
 {
-    if (length <= 0) {
-        return false;
-    }
-
-    QByteArray arr;
-    arr.reserve(length);
-
     QMutexLocker locker(&m_mutex);
-
-    for (quint32 i = 0; i < length; ++i) {
-        int c = std::getchar();
-        if (c == EOF) {
-            // message ended prematurely, ignore it and return
-            return false;
-        }
-        arr.append(static_cast<char>(c));
-    }
-
-    if (arr.length() > 0) {
-        sendReply(m_browserClients.readResponse(arr));
-    }
-    return true;
+    sendReply(m_browserClients.readResponse(message));
 }
 
 void NativeMessagingHost::newLocalConnection()
 {
-    QLocalSocket* socket = m_localServer->nextPendingConnection();
+    auto* server = qobject_cast<QLocalServer*>(QObject::sender());
+    QLocalSocket* socket = server ? server->nextPendingConnection() : nullptr;
     if (socket) {
         connect(socket, SIGNAL(readyRead()), this, SLOT(newLocalMessage()));
         connect(socket, SIGNAL(disconnected()), this, SLOT(disconnectSocket()));
@@ -158,41 +150,122 @@ void NativeMessagingHost::newLocalMessage()
         return;
     }
 
-    socket->setReadBufferSize(NATIVE_MSG_MAX_LENGTH);
+    socket->setReadBufferSize(NATIVE_MSG_MAX_LENGTH + PROXY_FRAME_HEADER_LENGTH);
     int socketDesc = socket->socketDescriptor();
     if (socketDesc) {
         int max = NATIVE_MSG_MAX_LENGTH;
         setsockopt(socketDesc, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<char*>(&max), sizeof(max));
     }
 
-    QByteArray arr = socket->readAll();
-    if (arr.isEmpty()) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_socketFraming.contains(socket)) {
+            // Newer proxies announce framed messages first, older ones send bare JSON right away
+            const QByteArray magic = proxyProtocolMagic();
+            const QByteArray start = socket->peek(magic.size());
+            if (start.size() < magic.size() && magic.startsWith(start)) {
+                return;
+            }
+            const bool framed = start == magic;
+            if (framed) {
+                socket->read(magic.size());
+            }
+            m_socketFraming.insert(socket, framed);
+        }
+        if (!m_socketList.contains(socket)) {
+            m_socketList.push_back(socket);
+        }
+    }
+
+    if (!m_socketFraming.value(socket)) {
+        QByteArray arr = socket->readAll();
+        if (!arr.isEmpty()) {
+            handleLocalMessage(socket, 0, arr);
+        }
         return;
     }
 
-    QMutexLocker locker(&m_mutex);
-    if (!m_socketList.contains(socket)) {
-        m_socketList.push_back(socket);
+    // Frames are taken straight from the socket buffer, incomplete ones wait for the next readyRead()
+    quint32 requestId = 0;
+    QByteArray payload;
+    bool ok = true;
+    while (readProxyFrame(socket, &requestId, &payload, &ok)) {
+        handleLocalMessage(socket, requestId, payload);
     }
+    if (!ok) {
+        qWarning("Closing browser proxy connection after an oversized frame");
+        socket->disconnectFromServer();
+    }
+}
+
+void NativeMessagingHost::handleLocalMessage(QLocalSocket* socket, quint32 requestId, const QByteArray& payload)
+{
+    m_pendingRequests[socket].enqueue({requestId, m_browserClients.byteArrayToJson(payload)});
+    processPendingRequests(socket);
+}
 
-    QString reply = jsonToString(m_browserClients.readResponse(arr));
+/**
+ * Answer the queued requests of a socket one after another.
+ *
+ * Replies keep the order of the requests and a request only starts once the
+ * previous one of the same client is answered, e.g. get-logins never runs
+ * before the test-associate sent ahead of it. Only requests of different
+ * clients are served in parallel.
+ */
+void NativeMessagingHost::processPendingRequests(QLocalSocket* socket)
+{
+    while (!m_busySockets.contains(socket)) {
+        auto queue = m_pendingRequests.find(socket);
+        if (queue == m_pendingRequests.end() || queue->isEmpty()) {
+            return;
+        }
+
+        const PendingRequest request = queue->dequeue();
+        m_busySockets.insert(socket);
+
+        if (BrowserAction::isReadOnlyAction(request.message.value("action").toString())) {
+            // Served from the pool so that an open dialog or a slow search does not hold up other clients,
+            // database access is still funneled through the GUI thread by BrowserService
+            auto* watcher = new QFutureWatcher<QJsonObject>(socket);
+            connect(watcher, &QFutureWatcher<QJsonObject>::finished, watcher, [this, socket, request, watcher] {
+                sendReplyToSocket(socket, request.requestId, watcher->result());
+                watcher->deleteLater();
+                m_busySockets.remove(socket);
+                processPendingRequests(socket);
+            });
+            const QJsonObject message = request.message;
+            watcher->setFuture(
+                QtConcurrent::run(&m_requestPool, [this, message] { return m_browserClients.readResponse(message); }));
+            return;
+        }
+
+        // May open a dialog, requests arriving meanwhile are queued behind this one
+        sendReplyToSocket(socket, request.requestId, m_browserClients.readResponse(request.message));
+        m_busySockets.remove(socket);
+    }
+}
+
+/**
+ * Replies on framed connections carry the ID of the request they answer,
+ * notifications that were not requested use 0.
+ */
+void NativeMessagingHost::sendReplyToSocket(QLocalSocket* socket, quint32 requestId, const QJsonObject& json)
+{
     if (socket && socket->isValid() && socket->state() == QLocalSocket::ConnectedState) {
-        QByteArray arr = reply.toUtf8();
-        socket->write(arr.constData(), arr.length());
+        QByteArray arr = jsonToUtf8(json);
+        if (m_socketFraming.value(socket)) {
+            arr = buildProxyFrame(requestId, arr);
+        }
+        socket->write(arr);
         socket->flush();
     }
 }
 
 void NativeMessagingHost::sendReplyToAllClients(const QJsonObject& json)
 {
-    QString reply = jsonToString(json);
     QMutexLocker locker(&m_mutex);
     for (const auto socket : m_socketList) {
-        if (socket && socket->isValid() && socket->state() == QLocalSocket::ConnectedState) {
-            QByteArray arr = reply.toUtf8();
-            socket->write(arr.constData(), arr.length());
-            socket->flush();
-        }
+        sendReplyToSocket(socket, 0, json);
     }
 }
 
@@ -205,6 +278,9 @@ void NativeMessagingHost::disconnectSocket()
             m_socketList.removeOne(s);
         }
     }
+    m_socketFraming.remove(socket);
+    m_pendingRequests.remove(socket);
+    m_busySockets.remove(socket);
 }
 
 void NativeMessagingHost::databaseLocked()
@@ -24,6 +24,11 @@
 #include "NativeMessagingBase.h"
 #include "gui/DatabaseTabWidget.h"
 
+#include <QHash>
+#include <QQueue>
+#include <QSet>
+#include <QThreadPool>
+
 class NativeMessagingHost : public NativeMessagingBase
 {
     Q_OBJECT
@@ -41,11 +46,13 @@ signals:
     void quit();
 
 private:
-    void readLength() override;
-    bool readStdIn(const quint32 length) override;
+    void handleLocalMessage(QLocalSocket* socket, quint32 requestId, const QByteArray& payload);
+    void processPendingRequests(QLocalSocket* socket);
+    void sendReplyToSocket(QLocalSocket* socket, quint32 requestId, const QJsonObject& json);
     void sendReplyToAllClients(const QJsonObject& json);
 
 private slots:
+    void handleNativeMessage(const QByteArray& message) override;
     void databaseLocked();
     void databaseUnlocked();
     void newLocalConnection();
@@ -57,7 +64,20 @@ private:
     BrowserService m_browserService;
     BrowserClients m_browserClients;
     QSharedPointer<QLocalServer> m_localServer;
+    QSharedPointer<QLocalServer> m_framedServer;
+    QThreadPool m_requestPool;
     SocketList m_socketList;
+    // Whether a connected proxy uses framed messages with request IDs
+    QHash<QLocalSocket*, bool> m_socketFraming;
+
+    struct PendingRequest
+    {
+        quint32 requestId;
+        QJsonObject message;
+    };
+    // Requests of a client waiting for the previous one to be answered
+    QHash<QLocalSocket*, QQueue<PendingRequest>> m_pendingRequests;
+    QSet<QLocalSocket*> m_busySockets;
 };
 
 #endif // NATIVEMESSAGINGHOST_H
@@ -0,0 +1,273 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AttachmentPool.h"
+
+#include "crypto/CryptoHash.h"
+#include "crypto/Random.h"
+#include "crypto/SymmetricCipher.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QMutexLocker>
+#include <QTemporaryFile>
+
+namespace
+{
+    // Multiple of the AES block size so the CTR keystream stays aligned between chunks
+    const int SpillChunkSize = 1024 * 1024;
+} // namespace
+
+AttachmentPool::Blob::Blob(const QByteArray& data, const QByteArray& digest)
+    : m_data(data)
+    , m_digest(digest)
+    , m_size(data.size())
+{
+}
+
+/**
+ * @param ok set to false if a spilled payload could not be read back
+ * @return the attachment payload, read back from the
+ *         backing file if the payload has been spilled
+ */
+QByteArray AttachmentPool::Blob::data(bool* ok) const
+{
+    if (ok) {
+        *ok = true;
+    }
+    if (!isSpilled()) {
+        return m_data;
+    }
+
+    QByteArray data;
+    data.reserve(m_size);
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!AttachmentPool::instance()->readSpilled(this, &buffer)) {
+        qWarning("AttachmentPool: unable to read back spilled attachment");
+        if (ok) {
+            *ok = false;
+        }
+        return {};
+    }
+    return data;
+}
+
+const QByteArray& AttachmentPool::Blob::digest() const
+{
+    return m_digest;
+}
+
+int AttachmentPool::Blob::size() const
+{
+    return m_size;
+}
+
+bool AttachmentPool::Blob::isSpilled() const
+{
+    return m_offset >= 0;
+}
+
+/**
+ * Write the payload to a device without holding more than
+ * one chunk of a spilled payload in memory.
+ *
+ * @param device output device
+ * @param readOk set to false if a spilled payload could not be read back
+ * @return true on success
+ */
+bool AttachmentPool::Blob::writeTo(QIODevice* device, bool* readOk) const
+{
+    if (!isSpilled()) {
+        if (readOk) {
+            *readOk = true;
+        }
+        return device->write(m_data) == m_data.size();
+    }
+    return AttachmentPool::instance()->readSpilled(this, device, readOk);
+}
+
+AttachmentPool::AttachmentPool()
+{
+}
+
+AttachmentPool::~AttachmentPool()
+{
+}
+
+AttachmentPool* AttachmentPool::instance()
+{
+    // Intentionally never destroyed, handles may outlive static destruction
+    static auto pool = new AttachmentPool();
+    return pool;
+}
+
+QByteArray AttachmentPool::digest(const QByteArray& data)
+{
+    return CryptoHash::hash(data, CryptoHash::Sha256);
+}
+
+/**
+ * Return the shared handle for the given payload, adding it
+ * to the pool if no identical payload is currently stored.
+ *
+ * @param data attachment payload
+ * @return reference counted handle to the pooled payload
+ */
+AttachmentPool::Handle AttachmentPool::intern(const QByteArray& data)
+{
+    const QByteArray key = digest(data);
+
+    QMutexLocker locker(&m_mutex);
+    Handle blob = m_blobs.value(key).toStrongRef();
+    if (!blob) {
+        auto newBlob = new Blob(data, key);
+        if (m_spillThreshold > 0 && data.size() >= m_spillThreshold) {
+            // Keep the payload resident if the backing file is unusable
+            spill(newBlob);
+        }
+        blob = Handle(newBlob, [this](const Blob* b) { release(b); });
+        m_blobs.insert(key, blob.toWeakRef());
+    }
+    return blob;
+}
+
+/**
+ * @return number of distinct payloads currently held by the pool
+ */
+int AttachmentPool::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_blobs.size();
+}
+
+int AttachmentPool::spillThreshold() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spillThreshold;
+}
+
+/**
+ * Set the payload size from which attachments are moved out of
+ * memory into the encrypted backing file. Only affects payloads
+ * interned afterwards.
+ *
+ * @param bytes minimum payload size, 0 keeps all payloads in memory
+ */
+void AttachmentPool::setSpillThreshold(int bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_spillThreshold = qMax(0, bytes);
+}
+
+void AttachmentPool::release(const Blob* blob)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_blobs.find(blob->digest());
+        // The slot may already hold a newer blob with the same content
+        if (it != m_blobs.end() && it.value().isNull()) {
+            m_blobs.erase(it);
+        }
+
+        if (blob->isSpilled() && --m_spilledCount == 0) {
+            // Nothing references the backing file anymore, reclaim its space
+            m_spillFile.reset();
+        }
+    }
+    delete blob;
+}
+
+bool AttachmentPool::spill(Blob* blob)
+{
+    if (!m_spillFile) {
+        m_spillFile.reset(new QTemporaryFile(QDir::temp().absoluteFilePath("keepassxc-attachments-XXXXXX")));
+        if (!m_spillFile->open()) {
+            qWarning("AttachmentPool: unable to create backing file: %s", qPrintable(m_spillFile->errorString()));
+            m_spillFile.reset();
+            return false;
+        }
+        m_spillKey = randomGen()->randomArray(32);
+    }
+
+    const QByteArray iv = randomGen()->randomArray(SymmetricCipher::algorithmIvSize(SymmetricCipher::Aes256));
+    SymmetricCipher cipher(SymmetricCipher::Aes256, SymmetricCipher::Ctr, SymmetricCipher::Encrypt);
+    if (!cipher.init(m_spillKey, iv)) {
+        return false;
+    }
+
+    const qint64 offset = m_spillFile->size();
+    if (!m_spillFile->seek(offset)) {
+        return false;
+    }
+
+    for (int pos = 0; pos < blob->m_data.size(); pos += SpillChunkSize) {
+        QByteArray chunk = blob->m_data.mid(pos, SpillChunkSize);
+        if (!cipher.processInPlace(chunk) || m_spillFile->write(chunk) != chunk.size()) {
+            qWarning("AttachmentPool: unable to write backing file: %s", qPrintable(m_spillFile->errorString()));
+            m_spillFile->resize(offset);
+            return false;
+        }
+    }
+
+    blob->m_offset = offset;
+    blob->m_iv = iv;
+    blob->m_data.clear();
+    ++m_spilledCount;
+    return true;
+}
+
+bool AttachmentPool::readSpilled(const Blob* blob, QIODevice* device, bool* readOk)
+{
+    Q_ASSERT(blob->isSpilled());
+
+    if (readOk) {
+        *readOk = true;
+    }
+    auto readFailed = [readOk]() {
+        if (readOk) {
+            *readOk = false;
+        }
+        return false;
+    };
+
+    SymmetricCipher cipher(SymmetricCipher::Aes256, SymmetricCipher::Ctr, SymmetricCipher::Decrypt);
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_spillFile || !cipher.init(m_spillKey, blob->m_iv)) {
+        return readFailed();
+    }
+
+    qint64 pos = blob->m_offset;
+    qint64 remaining = blob->m_size;
+    while (remaining > 0) {
+        if (!m_spillFile->seek(pos)) {
+            return readFailed();
+        }
+        QByteArray chunk = m_spillFile->read(qMin<qint64>(remaining, SpillChunkSize));
+        if (chunk.isEmpty() || !cipher.processInPlace(chunk)) {
+            return readFailed();
+        }
+        if (device->write(chunk) != chunk.size()) {
+            return false;
+        }
+        pos += chunk.size();
+        remaining -= chunk.size();
+    }
+
+    return true;
+}
@@ -0,0 +1,100 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_ATTACHMENTPOOL_H
+#define KEEPASSXC_ATTACHMENTPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+class QIODevice;
+class QTemporaryFile;
+
+/**
+ * Content-addressed store for attachment payloads.
+ *
+ * Every attachment is interned by its SHA-256 digest, so identical payloads
+ * (e.g. the same file carried across many history items) share one buffer.
+ * Handles are reference counted and the payload is dropped from the pool
+ * once the last handle goes away.
+ *
+ * Payloads at or above the spill threshold are not kept in memory. They are
+ * encrypted with a per-session key and written to a temporary backing file,
+ * and only read back while a caller needs them.
+ *
+ * The pool is process-wide rather than per database because entries and
+ * their history items regularly live outside of any database (clones,
+ * edit snapshots, merge sources) and move between databases.
+ */
+class AttachmentPool
+{
+public:
+    class Blob
+    {
+    public:
+        QByteArray data(bool* ok = nullptr) const;
+        const QByteArray& digest() const;
+        int size() const;
+        bool isSpilled() const;
+        bool writeTo(QIODevice* device, bool* readOk = nullptr) const;
+
+    private:
+        friend class AttachmentPool;
+        Blob(const QByteArray& data, const QByteArray& digest);
+
+        QByteArray m_data;
+        const QByteArray m_digest;
+        const int m_size;
+        qint64 m_offset = -1;
+        QByteArray m_iv;
+    };
+
+    using Handle = QSharedPointer<const Blob>;
+
+    static AttachmentPool* instance();
+
+    Handle intern(const QByteArray& data);
+    int count() const;
+
+    int spillThreshold() const;
+    void setSpillThreshold(int bytes);
+
+    static QByteArray digest(const QByteArray& data);
+
+private:
+    AttachmentPool();
+    ~AttachmentPool();
+
+    void release(const Blob* blob);
+    bool spill(Blob* blob);
+    bool readSpilled(const Blob* blob, QIODevice* device, bool* readOk = nullptr);
+
+    mutable QMutex m_mutex;
+    QHash<QByteArray, QWeakPointer<const Blob>> m_blobs;
+
+    int m_spillThreshold = 0;
+    int m_spilledCount = 0;
+    QScopedPointer<QTemporaryFile> m_spillFile;
+    QByteArray m_spillKey;
+
+    Q_DISABLE_COPY(AttachmentPool)
+};
+
+#endif // KEEPASSXC_ATTACHMENTPOOL_H
@@ -17,6 +17,7 @@
 
 #include "Bootstrap.h"
 #include "config-keepassx.h"
+#include "core/AttachmentPool.h"
 #include "core/Config.h"
 #include "core/Translator.h"
 #include "gui/MessageBox.h"
@@ -85,6 +86,10 @@ namespace Bootstrap
         bootstrap();
         MessageBox::initializeButtonDefs();
 
+        // Attachments of at least this many MiB are kept in an encrypted backing file instead of memory
+        const int attachmentThreshold = config()->get("LargeAttachmentThreshold").toInt();
+        AttachmentPool::instance()->setSpillThreshold(qBound(0, attachmentThreshold, 2047) * 1024 * 1024);
+
 #ifdef KEEPASSXC_DIST_SNAP
         // snap: force fallback theme to avoid using system theme (gtk integration)
         // with missing actions just like on Windows and macOS
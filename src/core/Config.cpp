@@ -189,6 +189,7 @@ void Config::init(const QString& fileName)
     m_defaults.insert("AutoSaveOnExit", true);
     m_defaults.insert("BackupBeforeSave", false);
     m_defaults.insert("UseAtomicSaves", true);
+    m_defaults.insert("LargeAttachmentThreshold", 64);
     m_defaults.insert("SearchLimitGroup", false);
     m_defaults.insert("MinimizeOnOpenUrl", false);
     m_defaults.insert("HideWindowOnCopy", false);
@@ -20,6 +20,7 @@
 
 #include "core/Clock.h"
 #include "core/FileWatcher.h"
+#include "core/Global.h"
 #include "core/Group.h"
 #include "core/Merger.h"
 #include "core/Metadata.h"
@@ -32,12 +33,19 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QSaveFile>
+#include <QSet>
 #include <QTemporaryFile>
 #include <QTimer>
 #include <QXmlStreamReader>
 
 QHash<QUuid, QPointer<Database>> Database::s_uuidMap;
 
+namespace
+{
+    // Stored in the database so that every client saving the file applies the same retention
+    const QString DeletedObjectsRetentionKey = QStringLiteral("KPXC_DELETED_OBJECTS_RETENTION_DAYS");
+} // namespace
+
 Database::Database()
     : m_metadata(new Metadata(this))
     , m_data()
@@ -55,8 +63,6 @@ Database::Database()
 
     connect(m_metadata, SIGNAL(metadataModified()), SLOT(markAsModified()));
     connect(&m_modifiedTimer, SIGNAL(timeout()), SIGNAL(databaseModified()));
-    connect(this, SIGNAL(databaseOpened()), SLOT(updateCommonUsernames()));
-    connect(this, SIGNAL(databaseSaved()), SLOT(updateCommonUsernames()));
     connect(m_fileWatcher, SIGNAL(fileChanged()), SIGNAL(databaseFileChanged()));
 
     m_modified = false;
@@ -321,6 +327,14 @@ bool Database::writeDatabase(QIODevice* device, QString* error)
         oldTransformedKey.setHash(m_data.transformedMasterKey->rawKey());
     }
 
+    const int retention = deletedObjectsRetention();
+    if (retention > 0) {
+        const int removed = compactDeletedObjects(Clock::currentDateTimeUtc().addDays(-retention));
+        if (removed > 0) {
+            qInfo("Dropped %d deleted objects older than %d days", removed, retention);
+        }
+    }
+
     KeePass2Writer writer;
     setEmitModified(false);
     writer.writeDatabase(device, this);
@@ -407,9 +421,15 @@ void Database::releaseData()
     if (m_fileWatcher) {
         delete m_fileWatcher;
     }
+    EntryAttributes::releaseUnusedKeys();
 
     m_deletedObjects.clear();
-    m_commonUsernames.clear();
+    m_deletedObjectUuids.clear();
+    m_countedUsernames.clear();
+    m_usernameCounts.clear();
+    m_usernameRanking.clear();
+    clearReferenceCache();
+    invalidatePathIndex();
 
     m_initialized = false;
     m_modified = false;
@@ -511,6 +531,8 @@ void Database::setRootGroup(Group* group)
 
     m_rootGroup = group;
     m_rootGroup->setParent(this);
+    clearReferenceCache();
+    invalidatePathIndex();
 }
 
 Metadata* Database::metadata()
@@ -571,22 +593,12 @@ const QList<DeletedObject>& Database::deletedObjects() const
 
 bool Database::containsDeletedObject(const QUuid& uuid) const
 {
-    for (const DeletedObject& currentObject : m_deletedObjects) {
-        if (currentObject.uuid == uuid) {
-            return true;
-        }
-    }
-    return false;
+    return m_deletedObjectUuids.contains(uuid);
 }
 
 bool Database::containsDeletedObject(const DeletedObject& object) const
 {
-    for (const DeletedObject& currentObject : m_deletedObjects) {
-        if (currentObject.uuid == object.uuid) {
-            return true;
-        }
-    }
-    return false;
+    return m_deletedObjectUuids.contains(object.uuid);
 }
 
 void Database::setDeletedObjects(const QList<DeletedObject>& delObjs)
@@ -595,12 +607,82 @@ void Database::setDeletedObjects(const QList<DeletedObject>& delObjs)
         return;
     }
     m_deletedObjects = delObjs;
+
+    m_deletedObjectUuids.clear();
+    m_deletedObjectUuids.reserve(m_deletedObjects.size());
+    for (const DeletedObject& object : asConst(m_deletedObjects)) {
+        ++m_deletedObjectUuids[object.uuid];
+    }
 }
 
 void Database::addDeletedObject(const DeletedObject& delObj)
 {
     Q_ASSERT(delObj.deletionTime.timeSpec() == Qt::UTC);
+    if (m_deletedObjectsBatch) {
+        m_deletedObjectsBatch->append(delObj);
+        return;
+    }
     m_deletedObjects.append(delObj);
+    ++m_deletedObjectUuids[delObj.uuid];
+}
+
+void Database::addDeletedObjects(const QList<DeletedObject>& delObjs)
+{
+    m_deletedObjects.reserve(m_deletedObjects.size() + delObjs.size());
+    m_deletedObjectUuids.reserve(m_deletedObjectUuids.size() + delObjs.size());
+    for (const DeletedObject& delObj : delObjs) {
+        Q_ASSERT(delObj.deletionTime.timeSpec() == Qt::UTC);
+        m_deletedObjects.append(delObj);
+        ++m_deletedObjectUuids[delObj.uuid];
+    }
+}
+
+/**
+ * Drop deleted objects which are older than the given time, keeping
+ * the order of the remaining ones.
+ *
+ * @param olderThan deletion time before which objects are dropped
+ * @return number of dropped objects
+ */
+int Database::compactDeletedObjects(const QDateTime& olderThan)
+{
+    QList<DeletedObject> remaining;
+    remaining.reserve(m_deletedObjects.size());
+    for (const DeletedObject& object : asConst(m_deletedObjects)) {
+        if (!object.deletionTime.isValid() || object.deletionTime >= olderThan) {
+            remaining.append(object);
+        }
+    }
+
+    const int removed = m_deletedObjects.size() - remaining.size();
+    if (removed > 0) {
+        setDeletedObjects(remaining);
+    }
+    return removed;
+}
+
+/**
+ * @return days deleted objects are kept before they are dropped on save, 0 if they are kept forever
+ */
+int Database::deletedObjectsRetention() const
+{
+    return qMax(0, m_metadata->customData()->value(DeletedObjectsRetentionKey).toInt());
+}
+
+/**
+ * Set how long deleted objects of this database are kept before they are
+ * dropped on save. Other copies of the database which have not been
+ * synchronized within this time may bring back the deleted items when merged.
+ *
+ * @param days retention in days, 0 keeps deleted objects forever
+ */
+void Database::setDeletedObjectsRetention(int days)
+{
+    if (days > 0) {
+        m_metadata->customData()->set(DeletedObjectsRetentionKey, QString::number(days));
+    } else if (m_metadata->customData()->contains(DeletedObjectsRetentionKey)) {
+        m_metadata->customData()->remove(DeletedObjectsRetentionKey);
+    }
 }
 
 void Database::addDeletedObject(const QUuid& uuid)
@@ -612,15 +694,190 @@ void Database::addDeletedObject(const QUuid& uuid)
     addDeletedObject(delObj);
 }
 
-QList<QString> Database::commonUsernames()
+/**
+ * Find the entry a field reference points to. Results are cached until
+ * the database is modified, so resolving the same reference repeatedly
+ * does not walk the whole tree each time.
+ *
+ * @param term text to search for
+ * @param referenceType field to search in
+ * @return first matching entry or nullptr
+ */
+Entry* Database::findEntryByReference(const QString& term, EntryReferenceType referenceType)
 {
-    return m_commonUsernames;
+    if (!m_rootGroup) {
+        return nullptr;
+    }
+
+    const QPair<int, QString> key(static_cast<int>(referenceType), term);
+    QMutexLocker locker(&m_referenceCacheMutex);
+    auto it = m_referenceCache.constFind(key);
+    if (it != m_referenceCache.constEnd()) {
+        return it.value();
+    }
+
+    Entry* entry = m_rootGroup->findEntryBySearchTerm(term, referenceType);
+    m_referenceCache.insert(key, entry);
+    return entry;
+}
+
+void Database::clearReferenceCache()
+{
+    QMutexLocker locker(&m_referenceCacheMutex);
+    m_referenceCache.clear();
+}
+
+void Database::invalidatePathIndex()
+{
+    QMutexLocker locker(&m_pathIndexMutex);
+    m_pathIndexValid = false;
+}
+
+void Database::buildPathIndex()
+{
+    m_entryPaths.clear();
+    m_entryTitles.clear();
+    m_groupPaths.clear();
+    m_entryPathList.clear();
+
+    if (m_rootGroup) {
+        indexPaths(m_rootGroup, "/");
+    }
+    m_pathIndexValid = true;
 }
 
-void Database::updateCommonUsernames(int topN)
+void Database::indexPaths(Group* group, const QString& path)
 {
-    m_commonUsernames.clear();
-    m_commonUsernames.append(rootGroup()->usernamesRecursive(topN));
+    // Same order as the recursive lookups in Group: the group itself, its entries, then its children
+    if (!m_groupPaths.contains(path)) {
+        m_groupPaths.insert(path, group);
+    }
+
+    for (Entry* entry : group->entries()) {
+        const QString entryPath = path + entry->title();
+        if (!m_entryPaths.contains(entryPath)) {
+            m_entryPaths.insert(entryPath, entry);
+        }
+        if (!m_entryTitles.contains(entry->title())) {
+            m_entryTitles.insert(entry->title(), entry);
+        }
+        m_entryPathList.append(entryPath);
+    }
+
+    for (Group* child : group->children()) {
+        indexPaths(child, path + child->name() + "/");
+    }
+}
+
+/**
+ * @param entryPath full path starting with a slash, or an entry title
+ * @return first entry below the root group with that path or title
+ */
+Entry* Database::findEntryByIndexedPath(const QString& entryPath)
+{
+    QMutexLocker locker(&m_pathIndexMutex);
+    if (!m_pathIndexValid) {
+        buildPathIndex();
+    }
+    return entryPath.startsWith("/") ? m_entryPaths.value(entryPath) : m_entryTitles.value(entryPath);
+}
+
+/**
+ * @param groupPath normalized path with leading and trailing slashes
+ * @return first group below the root group with that path
+ */
+Group* Database::findGroupByIndexedPath(const QString& groupPath)
+{
+    QMutexLocker locker(&m_pathIndexMutex);
+    if (!m_pathIndexValid) {
+        buildPathIndex();
+    }
+    return m_groupPaths.value(groupPath);
+}
+
+/**
+ * @return paths of all entries below the root group in tree order
+ */
+QStringList Database::indexedEntryPaths()
+{
+    QMutexLocker locker(&m_pathIndexMutex);
+    if (!m_pathIndexValid) {
+        buildPathIndex();
+    }
+    return m_entryPathList;
+}
+
+/**
+ * Usernames of all entries ordered by how often they are used,
+ * ties are ordered by name. History items are not counted, neither
+ * are usernames that reference another entry.
+ *
+ * @param topN maximum number of usernames, -1 returns all of them
+ * @return most used usernames
+ */
+QList<QString> Database::commonUsernames(int topN) const
+{
+    QList<QString> usernames;
+    for (const auto& ranked : m_usernameRanking) {
+        if (topN >= 0 && usernames.size() >= topN) {
+            break;
+        }
+        usernames.append(ranked.second);
+    }
+    return usernames;
+}
+
+/**
+ * Start maintaining the per entry state of an entry that became part of
+ * this database. Listeners are told through entryAdded().
+ */
+void Database::trackEntry(Entry* entry)
+{
+    connect(entry, &Entry::entryModified, this, [this, entry]() { updateUsernameCount(entry); });
+    updateUsernameCount(entry);
+    emit entryAdded(entry);
+}
+
+void Database::untrackEntry(Entry* entry)
+{
+    uncountUsername(entry);
+    emit entryRemoved(entry);
+}
+
+void Database::uncountUsername(const Entry* entry)
+{
+    auto it = m_countedUsernames.find(entry);
+    if (it != m_countedUsernames.end()) {
+        addUsernameCount(it.value(), -1);
+        m_countedUsernames.erase(it);
+    }
+}
+
+void Database::updateUsernameCount(const Entry* entry)
+{
+    const QString username = entry->username();
+    auto it = m_countedUsernames.find(entry);
+    if (it != m_countedUsernames.end() && it.value() == username) {
+        return;
+    }
+
+    uncountUsername(entry);
+    if (!username.isEmpty() && !entry->isAttributeReference(EntryAttributes::UserNameKey)) {
+        m_countedUsernames.insert(entry, username);
+        addUsernameCount(username, 1);
+    }
+}
+
+void Database::addUsernameCount(const QString& username, int delta)
+{
+    int& count = m_usernameCounts[username];
+    m_usernameRanking.erase({-count, username});
+    count += delta;
+    if (count > 0) {
+        m_usernameRanking.insert({-count, username});
+    } else {
+        m_usernameCounts.remove(username);
+    }
 }
 
 const QUuid& Database::cipher() const
@@ -797,7 +1054,7 @@ void Database::recycleEntry(Entry* entry)
         }
         entry->setGroup(metadata()->recycleBin());
     } else {
-        delete entry;
+        deleteItems({entry});
     }
 }
 
@@ -810,7 +1067,7 @@ void Database::recycleGroup(Group* group)
         }
         group->setParent(metadata()->recycleBin());
     } else {
-        delete group;
+        deleteItems({}, {group});
     }
 }
 
@@ -818,17 +1075,72 @@ void Database::emptyRecycleBin()
 {
     Q_ASSERT(!m_data.isReadOnly);
     if (m_metadata->recycleBinEnabled() && m_metadata->recycleBin()) {
-        // destroying direct entries of the recycle bin
-        QList<Entry*> subEntries = m_metadata->recycleBin()->entries();
-        for (Entry* entry : subEntries) {
-            delete entry;
+        deleteItems(m_metadata->recycleBin()->entries(), m_metadata->recycleBin()->children());
+    }
+}
+
+/**
+ * Permanently delete entries and groups together with everything below them.
+ *
+ * Each group is detached from the database as a whole before it is destroyed,
+ * so its contents do not notify the database one by one. The deleted objects
+ * of all items are recorded in one batch and listeners see a single bulk update.
+ *
+ * @param entries entries to delete
+ * @param groups groups to delete, must not contain the root group
+ */
+void Database::deleteItems(const QList<Entry*>& entries, const QList<Group*>& groups)
+{
+    Q_ASSERT(!m_data.isReadOnly);
+
+    QSet<const Group*> deletedGroups;
+    for (const Group* group : groups) {
+        Q_ASSERT(group && group->database() == this && group != m_rootGroup);
+        deletedGroups.insert(group);
+    }
+
+    // Items below another deleted group are destroyed together with it
+    auto isBelowDeletedGroup = [&deletedGroups](const Group* group) {
+        for (; group; group = group->parentGroup()) {
+            if (deletedGroups.contains(group)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    QList<Group*> topGroups;
+    for (Group* group : groups) {
+        if (group && group != m_rootGroup && !isBelowDeletedGroup(group->parentGroup())) {
+            topGroups.append(group);
         }
-        // destroying direct subgroups of the recycle bin
-        QList<Group*> subGroups = m_metadata->recycleBin()->children();
-        for (Group* group : subGroups) {
-            delete group;
+    }
+    QList<Entry*> topEntries;
+    for (Entry* entry : entries) {
+        Q_ASSERT(entry && entry->group() && entry->group()->database() == this);
+        if (entry && !isBelowDeletedGroup(entry->group())) {
+            topEntries.append(entry);
         }
     }
+
+    if (topGroups.isEmpty() && topEntries.isEmpty()) {
+        return;
+    }
+
+    BulkUpdate bulkUpdate(this);
+    QList<DeletedObject> deletedObjects;
+    m_deletedObjectsBatch = &deletedObjects;
+
+    for (Group* group : asConst(topGroups)) {
+        group->detachFromDatabase();
+    }
+    for (Entry* entry : asConst(topEntries)) {
+        delete entry;
+    }
+    qDeleteAll(topGroups);
+
+    m_deletedObjectsBatch = nullptr;
+    addDeletedObjects(deletedObjects);
 }
 
 void Database::setEmitModified(bool value)
@@ -840,6 +1152,57 @@ void Database::setEmitModified(bool value)
     m_emitModified = value;
 }
 
+/**
+ * Start a batch of structural or data changes, e.g. an import or a merge.
+ *
+ * Listeners receive bulkUpdateStarted() before the first change and
+ * bulkUpdateFinished() after the last one. Views are expected to ignore
+ * the per item signals in between and refresh once at the end. The
+ * databaseModified() notification is deferred until the batch ends.
+ * Calls can be nested, only the outermost pair emits signals.
+ */
+void Database::beginBulkUpdate()
+{
+    if (m_bulkUpdateDepth++ == 0) {
+        m_bulkUpdateModified = false;
+        emit bulkUpdateStarted();
+    }
+}
+
+void Database::endBulkUpdate()
+{
+    Q_ASSERT(m_bulkUpdateDepth > 0);
+    if (m_bulkUpdateDepth <= 0 || --m_bulkUpdateDepth > 0) {
+        return;
+    }
+
+    emit bulkUpdateFinished();
+    if (m_bulkUpdateModified) {
+        m_bulkUpdateModified = false;
+        markAsModified();
+    }
+}
+
+bool Database::isBulkUpdating() const
+{
+    return m_bulkUpdateDepth > 0;
+}
+
+Database::BulkUpdate::BulkUpdate(Database* db)
+    : m_db(db)
+{
+    if (m_db) {
+        m_db->beginBulkUpdate();
+    }
+}
+
+Database::BulkUpdate::~BulkUpdate()
+{
+    if (m_db) {
+        m_db->endBulkUpdate();
+    }
+}
+
 bool Database::isModified() const
 {
     return m_modified;
@@ -847,7 +1210,15 @@ bool Database::isModified() const
 
 void Database::markAsModified()
 {
+    // Every entry and group change ends up here, any of them may change what a reference resolves to
+    clearReferenceCache();
+    invalidatePathIndex();
+
     m_modified = true;
+    if (m_bulkUpdateDepth > 0) {
+        m_bulkUpdateModified = true;
+        return;
+    }
     if (m_emitModified && !m_modifiedTimer.isActive()) {
         // Small time delay prevents numerous consecutive saves due to repeated signals
         m_modifiedTimer.start(150);
@@ -21,10 +21,14 @@
 
 #include <QDateTime>
 #include <QHash>
+#include <QMutex>
 #include <QPointer>
 #include <QScopedPointer>
+#include <QStringList>
 #include <QTimer>
 
+#include <set>
+
 #include "config-keepassx.h"
 #include "crypto/kdf/AesKdf.h"
 #include "crypto/kdf/Kdf.h"
@@ -63,6 +67,21 @@ public:
     };
     static const quint32 CompressionAlgorithmMax = CompressionGZip;
 
+    /**
+     * Scoped bulk update, see beginBulkUpdate()
+     */
+    class BulkUpdate
+    {
+    public:
+        explicit BulkUpdate(Database* db);
+        ~BulkUpdate();
+
+    private:
+        QPointer<Database> m_db;
+
+        Q_DISABLE_COPY(BulkUpdate)
+    };
+
     Database();
     explicit Database(const QString& filePath);
     ~Database() override;
@@ -85,6 +104,9 @@ public:
     void setEmitModified(bool value);
     bool isReadOnly() const;
     void setReadOnly(bool readOnly);
+    void beginBulkUpdate();
+    void endBulkUpdate();
+    bool isBulkUpdating() const;
 
     QUuid uuid() const;
     QString filePath() const;
@@ -103,15 +125,22 @@ public:
     void recycleGroup(Group* group);
     void recycleEntry(Entry* entry);
     void emptyRecycleBin();
+    void deleteItems(const QList<Entry*>& entries, const QList<Group*>& groups = {});
     QList<DeletedObject> deletedObjects();
     const QList<DeletedObject>& deletedObjects() const;
     void addDeletedObject(const DeletedObject& delObj);
     void addDeletedObject(const QUuid& uuid);
+    void addDeletedObjects(const QList<DeletedObject>& delObjs);
     bool containsDeletedObject(const QUuid& uuid) const;
     bool containsDeletedObject(const DeletedObject& uuid) const;
     void setDeletedObjects(const QList<DeletedObject>& delObjs);
+    int compactDeletedObjects(const QDateTime& olderThan);
+    int deletedObjectsRetention() const;
+    void setDeletedObjectsRetention(int days);
+
+    QList<QString> commonUsernames(int topN = 10) const;
 
-    QList<QString> commonUsernames();
+    Entry* findEntryByReference(const QString& term, EntryReferenceType referenceType);
 
     bool hasKey() const;
     QSharedPointer<const CompositeKey> key() const;
@@ -137,7 +166,6 @@ public:
 public slots:
     void markAsModified();
     void markAsClean();
-    void updateCommonUsernames(int topN = 10);
 
 signals:
     void filePathChanged(const QString& oldPath, const QString& newPath);
@@ -153,6 +181,10 @@ signals:
     void databaseSaved();
     void databaseDiscarded();
     void databaseFileChanged();
+    void bulkUpdateStarted();
+    void bulkUpdateFinished();
+    void entryAdded(Entry* entry);
+    void entryRemoved(Entry* entry);
 
 private:
     struct DatabaseData
@@ -196,7 +228,21 @@ private:
         }
     };
 
+    friend class Group;
+
     void createRecycleBin();
+    void clearReferenceCache();
+    void invalidatePathIndex();
+    void buildPathIndex();
+    void indexPaths(Group* group, const QString& path);
+    Entry* findEntryByIndexedPath(const QString& entryPath);
+    Group* findGroupByIndexedPath(const QString& groupPath);
+    QStringList indexedEntryPaths();
+    void trackEntry(Entry* entry);
+    void untrackEntry(Entry* entry);
+    void uncountUsername(const Entry* entry);
+    void updateUsernameCount(const Entry* entry);
+    void addUsernameCount(const QString& username, int delta);
 
     bool writeDatabase(QIODevice* device, QString* error = nullptr);
     bool backupDatabase(const QString& filePath);
@@ -207,13 +253,36 @@ private:
     DatabaseData m_data;
     QPointer<Group> m_rootGroup;
     QList<DeletedObject> m_deletedObjects;
+    // number of deleted objects per uuid, keeps lookups constant time
+    QHash<QUuid, int> m_deletedObjectUuids;
+    // set while deleteItems() runs, deleted objects are collected here and added in one go
+    QList<DeletedObject>* m_deletedObjectsBatch = nullptr;
     QTimer m_modifiedTimer;
     QPointer<FileWatcher> m_fileWatcher;
     bool m_initialized = false;
     bool m_modified = false;
     bool m_emitModified;
-
-    QList<QString> m_commonUsernames;
+    int m_bulkUpdateDepth = 0;
+    bool m_bulkUpdateModified = false;
+
+    // Username frequencies of all entries, maintained as entries are added, changed and removed
+    QHash<const Entry*, QString> m_countedUsernames;
+    QHash<QString, int> m_usernameCounts;
+    // (-count, username) so iteration yields the most used usernames first
+    std::set<QPair<int, QString>> m_usernameRanking;
+
+    // {REF:...} lookups by (search in field, search text), cleared on every modification
+    QHash<QPair<int, QString>, Entry*> m_referenceCache;
+    QMutex m_referenceCacheMutex;
+
+    // Paths below the root group, rebuilt on the first lookup after a modification.
+    // Duplicate paths resolve to the first match in tree order.
+    QHash<QString, Entry*> m_entryPaths;
+    QHash<QString, Entry*> m_entryTitles;
+    QHash<QString, Group*> m_groupPaths;
+    QStringList m_entryPathList;
+    bool m_pathIndexValid = false;
+    QMutex m_pathIndexMutex;
 
     QUuid m_uuid;
     static QHash<QUuid, QPointer<Database>> s_uuidMap;
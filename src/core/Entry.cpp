@@ -25,10 +25,13 @@
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "core/Tools.h"
+#include "crypto/CryptoHash.h"
 #include "totp/totp.h"
 
+#include <QDataStream>
 #include <QDir>
 #include <QRegularExpression>
+#include <limits>
 #include <utility>
 
 const int Entry::DefaultIconNumber = 0;
@@ -57,6 +60,11 @@ Entry::Entry()
 
     connect(this, SIGNAL(entryModified()), SLOT(updateTimeinfo()));
     connect(this, SIGNAL(entryModified()), SLOT(updateModifiedSinceBegin()));
+    connect(this, &Entry::entryModified, this, [this]() {
+        m_digest.clear();
+        m_parsedUrls.clear();
+        m_decodedCustomData.clear();
+    });
 }
 
 Entry::~Entry()
@@ -316,6 +324,40 @@ QString Entry::displayUrl() const
     return resolveMultiplePlaceholders(url);
 }
 
+/**
+ * Get a URL attribute in parsed form. The result is cached until the
+ * entry or the attribute value changes.
+ *
+ * @param key attribute holding the URL, e.g. an additional URL
+ * @return parsed URL
+ */
+EntryUrl Entry::parsedUrl(const QString& key) const
+{
+    const QString value = m_attributes->value(key);
+    auto it = m_parsedUrls.find(key);
+    if (it == m_parsedUrls.end() || it->raw != value) {
+        it = m_parsedUrls.insert(key, EntryUrl::parse(value));
+    }
+    return it.value();
+}
+
+/**
+ * Get a custom data value in decoded form, e.g. settings stored as JSON.
+ * The result is cached until the entry changes.
+ *
+ * @param key custom data key
+ * @param decode turns the raw value into its decoded form
+ * @return decoded value
+ */
+QVariant Entry::decodedCustomData(const QString& key, QVariant (*decode)(const QString& value)) const
+{
+    auto it = m_decodedCustomData.find(key);
+    if (it == m_decodedCustomData.end()) {
+        it = m_decodedCustomData.insert(key, decode(m_customData->value(key)));
+    }
+    return it.value();
+}
+
 QString Entry::username() const
 {
     return m_attributes->value(EntryAttributes::UserNameKey);
@@ -531,6 +573,7 @@ void Entry::setTags(const QString& tags)
 void Entry::setTimeInfo(const TimeInfo& timeInfo)
 {
     m_data.timeInfo = timeInfo;
+    m_digest.clear();
 }
 
 void Entry::setAutoTypeEnabled(bool enable)
@@ -620,6 +663,18 @@ void Entry::addHistoryItem(Entry* entry)
 {
     Q_ASSERT(!entry->parent());
 
+    // Unchanged values share their storage with the newer versions of the entry
+    entry->m_attributes->shareValuesWith(m_attributes);
+    if (!m_history.isEmpty()) {
+        entry->m_attributes->shareValuesWith(m_history.last()->m_attributes);
+    }
+
+    if (m_historySize >= 0) {
+        m_historySize += entry->dataSize();
+    }
+    // History items are rarely edited in place, recompute the size if it happens
+    connect(entry, &Entry::entryModified, this, [this]() { m_historySize = -1; });
+
     m_history.append(entry);
     emit entryModified();
 }
@@ -636,6 +691,9 @@ void Entry::removeHistoryItems(const QList<Entry*>& historyEntries)
         Q_ASSERT(m_history.contains(entry));
 
         m_history.removeOne(entry);
+        if (m_historySize >= 0) {
+            m_historySize -= entry->dataSize();
+        }
         delete entry;
     }
 
@@ -652,49 +710,72 @@ void Entry::truncateHistory()
 
     int histMaxItems = db->metadata()->historyMaxItems();
     if (histMaxItems > -1) {
-        int historyCount = 0;
-        QMutableListIterator<Entry*> i(m_history);
-        i.toBack();
-        while (i.hasPrevious()) {
-            historyCount++;
-            Entry* entry = i.previous();
-            if (historyCount > histMaxItems) {
-                delete entry;
-                i.remove();
+        while (m_history.size() > histMaxItems) {
+            Entry* entry = m_history.takeFirst();
+            if (m_historySize >= 0) {
+                m_historySize -= entry->dataSize();
             }
+            delete entry;
         }
     }
 
+    // The running size keeps this a constant time check while below the limit
     int histMaxSize = db->metadata()->historyMaxSize();
-    if (histMaxSize > -1) {
+    if (histMaxSize > -1 && historySize() > histMaxSize) {
         int size = 0;
-        QSet<QByteArray> foundAttachments = attachments()->values();
+        int keptSize = 0;
 
         QMutableListIterator<Entry*> i(m_history);
         i.toBack();
-        const QRegularExpression delimiter(",|:|;");
         while (i.hasPrevious()) {
             Entry* historyItem = i.previous();
 
             // don't calculate size if it's already above the maximum
             if (size <= histMaxSize) {
-                size += historyItem->attributes()->attributesSize();
-                size += historyItem->autoTypeAssociations()->associationsSize();
-                size += historyItem->attachments()->attachmentsSize();
-                size += historyItem->customData()->dataSize();
-                const QStringList tags = historyItem->tags().split(delimiter, QString::SkipEmptyParts);
-                for (const QString& tag : tags) {
-                    size += tag.toUtf8().size();
-                }
-                foundAttachments += historyItem->attachments()->values();
+                size += historyItem->dataSize();
             }
 
             if (size > histMaxSize) {
                 delete historyItem;
                 i.remove();
+            } else {
+                keptSize = size;
             }
         }
+
+        m_historySize = keptSize;
+    }
+}
+
+/**
+ * @return combined size of all history items as counted against the history size limit
+ */
+int Entry::historySize() const
+{
+    if (m_historySize < 0) {
+        int size = 0;
+        for (const Entry* historyItem : m_history) {
+            size += historyItem->dataSize();
+        }
+        m_historySize = size;
+    }
+    return m_historySize;
+}
+
+int Entry::dataSize() const
+{
+    int size = 0;
+    size += m_attributes->attributesSize();
+    size += m_autoTypeAssociations->associationsSize();
+    size += m_attachments->attachmentsSize();
+    size += m_customData->dataSize();
+
+    static const QRegularExpression delimiter(",|:|;");
+    const QStringList tagList = tags().split(delimiter, QString::SkipEmptyParts);
+    for (const QString& tag : tagList) {
+        size += tag.toUtf8().size();
     }
+    return size;
 }
 
 bool Entry::equals(const Entry* other, CompareItemOptions options) const
@@ -702,23 +783,28 @@ bool Entry::equals(const Entry* other, CompareItemOptions options) const
     if (!other) {
         return false;
     }
+    // Checked before the digest, which would serialize and hash both entries
     if (m_uuid != other->uuid()) {
         return false;
     }
-    if (!m_data.equals(other->m_data, options)) {
-        return false;
-    }
-    if (*m_customData != *other->m_customData) {
-        return false;
-    }
-    if (*m_attributes != *other->m_attributes) {
-        return false;
-    }
-    if (*m_attachments != *other->m_attachments) {
-        return false;
-    }
-    if (*m_autoTypeAssociations != *other->m_autoTypeAssociations) {
-        return false;
+    // Matching digests mean identical content, which is equal under any options. Different
+    // digests are not conclusive, e.g. null and empty strings are serialized differently
+    if (digest() != other->digest()) {
+        if (!m_data.equals(other->m_data, options)) {
+            return false;
+        }
+        if (*m_customData != *other->m_customData) {
+            return false;
+        }
+        if (*m_attributes != *other->m_attributes) {
+            return false;
+        }
+        if (*m_attachments != *other->m_attachments) {
+            return false;
+        }
+        if (*m_autoTypeAssociations != *other->m_autoTypeAssociations) {
+            return false;
+        }
     }
     if (!options.testFlag(CompareItemIgnoreHistory)) {
         if (m_history.count() != other->m_history.count()) {
@@ -733,6 +819,72 @@ bool Entry::equals(const Entry* other, CompareItemOptions options) const
     return true;
 }
 
+/**
+ * Digest over everything equals() compares except the history items.
+ * It is computed on first use and dropped whenever the entry changes.
+ *
+ * @return SHA-256 digest of the entry content
+ */
+QByteArray Entry::digest() const
+{
+    if (!m_digest.isEmpty()) {
+        return m_digest;
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << m_uuid << m_data.iconNumber << m_data.customIcon << m_data.foregroundColor << m_data.backgroundColor
+           << m_data.overrideUrl << m_data.tags << m_data.autoTypeEnabled << m_data.autoTypeObfuscation
+           << m_data.defaultAutoTypeSequence;
+
+    // Date times compare equal across time specs, hash the point in time only
+    const TimeInfo& timeInfo = m_data.timeInfo;
+    const QDateTime dateTimes[] = {timeInfo.lastModificationTime(),
+                                   timeInfo.creationTime(),
+                                   timeInfo.lastAccessTime(),
+                                   timeInfo.expiryTime(),
+                                   timeInfo.locationChanged()};
+    for (const QDateTime& dateTime : dateTimes) {
+        stream << (dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min());
+    }
+    stream << timeInfo.expires() << timeInfo.usageCount();
+
+    // Same TOTP fields as EntryData::equals()
+    stream << !m_data.totpSettings.isNull();
+    if (m_data.totpSettings) {
+        stream << m_data.totpSettings->key << m_data.totpSettings->digits << m_data.totpSettings->step;
+    }
+
+    QList<QString> customDataKeys = m_customData->keys();
+    std::sort(customDataKeys.begin(), customDataKeys.end());
+    stream << customDataKeys.size();
+    for (const QString& key : asConst(customDataKeys)) {
+        stream << key << m_customData->value(key);
+    }
+
+    const QList<QString> attributeKeys = m_attributes->keys();
+    stream << attributeKeys.size();
+    for (const QString& key : attributeKeys) {
+        stream << key << m_attributes->value(key) << m_attributes->isProtected(key);
+    }
+
+    // Attachments are pooled by content, their digests stand in for the payloads
+    const QList<QString> attachmentKeys = m_attachments->keys();
+    stream << attachmentKeys.size();
+    for (const QString& key : attachmentKeys) {
+        stream << key << m_attachments->digest(key);
+    }
+
+    const QList<AutoTypeAssociations::Association> associations = m_autoTypeAssociations->getAll();
+    stream << associations.size();
+    for (const auto& association : associations) {
+        stream << association.window << association.sequence;
+    }
+
+    m_digest = CryptoHash::hash(data, CryptoHash::Sha256);
+    return m_digest;
+}
+
 Entry* Entry::clone(CloneFlags flags) const
 {
     Entry* entry = new Entry();
@@ -782,6 +934,13 @@ Entry* Entry::clone(CloneFlags flags) const
     if (flags & CloneRenameTitle)
         entry->setTitle(tr("%1 - Clone").arg(entry->title()));
 
+    // Exact copies keep the cached digest, custom data may still differ by its modification stamp
+    const CloneFlags changingFlags =
+        CloneNewUuid | CloneResetTimeInfo | CloneRenameTitle | CloneUserAsRef | ClonePassAsRef;
+    if (!(flags & changingFlags) && *entry->m_customData == *m_customData) {
+        entry->m_digest = m_digest;
+    }
+
     entry->setUpdateTimeinfo(true);
 
     return entry;
@@ -795,6 +954,8 @@ void Entry::copyDataFrom(const Entry* other)
     m_attributes->copyDataFrom(other->m_attributes);
     m_attachments->copyDataFrom(other->m_attachments);
     m_autoTypeAssociations->copyDataFrom(other->m_autoTypeAssociations);
+    m_digest.clear();
+    m_decodedCustomData.clear();
     setUpdateTimeinfo(true);
 }
 
@@ -943,7 +1104,7 @@ QString Entry::resolveReferencePlaceholderRecursive(const QString& placeholder,
 
     Q_ASSERT(m_group);
     Q_ASSERT(m_group->database());
-    const Entry* refEntry = m_group->database()->rootGroup()->findEntryBySearchTerm(searchText, searchInType);
+    const Entry* refEntry = m_group->database()->findEntryByReference(searchText, searchInType);
 
     if (refEntry) {
         const QString wantedField = match.captured(EntryAttributes::WantedFieldGroupName);
@@ -1018,6 +1179,7 @@ void Entry::setGroup(Group* group)
 
     if (m_updateTimeinfo) {
         m_data.timeInfo.setLocationChanged(Clock::currentDateTimeUtc());
+        m_digest.clear();
     }
 }
 
@@ -1060,7 +1222,7 @@ Entry* Entry::resolveReference(const QString& str) const
     const QString searchText = match.captured(EntryAttributes::SearchTextGroupName);
 
     const EntryReferenceType searchInType = Entry::referenceType(searchIn);
-    return m_group->database()->rootGroup()->findEntryBySearchTerm(searchText, searchInType);
+    return m_group->database()->findEntryByReference(searchText, searchInType);
 }
 
 QString Entry::resolveMultiplePlaceholders(const QString& str) const
@@ -1182,6 +1344,37 @@ QString Entry::resolveUrl(const QString& url) const
     return QString("");
 }
 
+EntryUrl EntryUrl::parse(const QString& url)
+{
+    EntryUrl parsed;
+    parsed.raw = url;
+    parsed.hasPlaceholders = url.contains('{');
+
+    if (!url.isEmpty()) {
+        parsed.hasScheme = url.contains("://");
+        parsed.url = parsed.hasScheme ? QUrl(url) : QUrl::fromUserInput(url);
+        parsed.host = parsed.url.host();
+        parsed.baseDomain = parsed.host.isEmpty() ? QString() : Tools::baseDomain(parsed.host);
+        parsed.port = parsed.url.port();
+        parsed.path = parsed.url.path();
+    }
+
+    QUrl literal(url);
+    if (literal.scheme().isEmpty()) {
+        literal.setScheme("https");
+    }
+    // Add the empty path to the URL if it's missing
+    if (literal.path().isEmpty() && !literal.hasFragment() && !literal.hasQuery()) {
+        literal.setPath("/");
+    }
+    parsed.normalized = literal.toString(QUrl::StripTrailingSlash);
+    parsed.normalizedBase =
+        literal.toString(QUrl::StripTrailingSlash | QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment);
+    parsed.normalizedHost = literal.host();
+
+    return parsed;
+}
+
 bool EntryData::operator==(const EntryData& other) const
 {
     return equals(other, CompareItemDefault);
@@ -27,6 +27,7 @@
 #include <QSet>
 #include <QUrl>
 #include <QUuid>
+#include <QVariant>
 
 #include "core/AutoTypeAssociations.h"
 #include "core/CustomData.h"
@@ -72,6 +73,29 @@ struct EntryData
     bool equals(const EntryData& other, CompareItemOptions options) const;
 };
 
+/**
+ * Entry URL split into the parts it is matched and ranked by, see Entry::parsedUrl()
+ */
+struct EntryUrl
+{
+    QString raw;
+    // Parsed like user input if the scheme is missing
+    QUrl url;
+    bool hasScheme = false;
+    QString host;
+    QString baseDomain;
+    int port = -1;
+    QString path;
+    // Parsed literally with https and / as defaults, without trailing slash
+    QString normalized;
+    // normalized without path, query and fragment
+    QString normalizedBase;
+    QString normalizedHost;
+    bool hasPlaceholders = false;
+
+    static EntryUrl parse(const QString& url);
+};
+
 class Entry : public QObject
 {
     Q_OBJECT
@@ -102,6 +126,8 @@ public:
     QString url() const;
     QString webUrl() const;
     QString displayUrl() const;
+    EntryUrl parsedUrl(const QString& key = EntryAttributes::URLKey) const;
+    QVariant decodedCustomData(const QString& key, QVariant (*decode)(const QString& value)) const;
     QString username() const;
     QString password() const;
     QString notes() const;
@@ -155,8 +181,10 @@ public:
     void addHistoryItem(Entry* entry);
     void removeHistoryItems(const QList<Entry*>& historyEntries);
     void truncateHistory();
+    int historySize() const;
 
     bool equals(const Entry* other, CompareItemOptions options = CompareItemDefault) const;
+    QByteArray digest() const;
 
     enum CloneFlag
     {
@@ -244,6 +272,7 @@ private:
     QString resolvePlaceholderRecursive(const QString& placeholder, int maxDepth) const;
     QString resolveReferencePlaceholderRecursive(const QString& placeholder, int maxDepth) const;
     QString referenceFieldValue(EntryReferenceType referenceType) const;
+    int dataSize() const;
 
     static QString buildReference(const QUuid& uuid, const QString& field);
     static EntryReferenceType referenceType(const QString& referenceStr);
@@ -257,6 +286,10 @@ private:
     QPointer<AutoTypeAssociations> m_autoTypeAssociations;
     QPointer<CustomData> m_customData;
     QList<Entry*> m_history; // Items sorted from oldest to newest
+    mutable int m_historySize = -1; // Sum of the history item sizes, -1 if it has to be recomputed
+    mutable QByteArray m_digest; // Content digest, empty until requested and after every change
+    mutable QHash<QString, EntryUrl> m_parsedUrls; // Parsed URL attributes by key, see parsedUrl()
+    mutable QHash<QString, QVariant> m_decodedCustomData; // Decoded custom data by key, see decodedCustomData()
 
     QScopedPointer<Entry> m_tmpHistoryItem;
     bool m_modifiedSinceBegin;
@@ -17,8 +17,6 @@
 
 #include "EntryAttachments.h"
 
-#include "core/Global.h"
-
 #include <QSet>
 #include <QStringList>
 
@@ -39,16 +37,81 @@ bool EntryAttachments::hasKey(const QString& key) const
 
 QSet<QByteArray> EntryAttachments::values() const
 {
-    return asConst(m_attachments).values().toSet();
+    QSet<QByteArray> values;
+    for (const auto& blob : m_attachments) {
+        values.insert(blob->data());
+    }
+    return values;
 }
 
-QByteArray EntryAttachments::value(const QString& key) const
+/**
+ * @param key attachment name
+ * @param ok set to false if the payload could not be loaded
+ * @return attachment payload
+ */
+QByteArray EntryAttachments::value(const QString& key, bool* ok) const
+{
+    const auto blob = m_attachments.value(key);
+    if (!blob) {
+        if (ok) {
+            *ok = true;
+        }
+        return {};
+    }
+    return blob->data(ok);
+}
+
+/**
+ * @param key attachment name
+ * @return content digest of the attachment, used to deduplicate
+ *         payloads without hashing them again
+ */
+QByteArray EntryAttachments::digest(const QString& key) const
+{
+    const auto blob = m_attachments.value(key);
+    return blob ? blob->digest() : QByteArray();
+}
+
+/**
+ * @param key attachment name
+ * @return payload size in bytes, without loading a spilled payload
+ */
+int EntryAttachments::size(const QString& key) const
 {
-    return m_attachments.value(key);
+    const auto blob = m_attachments.value(key);
+    return blob ? blob->size() : 0;
+}
+
+/**
+ * Stream an attachment into a device. Prefer this over value()
+ * for large attachments that may not be resident in memory.
+ *
+ * @param key attachment name
+ * @param device output device
+ * @param readOk set to false if the attachment could not be read
+ * @return true on success
+ */
+bool EntryAttachments::writeToDevice(const QString& key, QIODevice* device, bool* readOk) const
+{
+    const auto blob = m_attachments.value(key);
+    if (!blob) {
+        if (readOk) {
+            *readOk = false;
+        }
+        return false;
+    }
+    return blob->writeTo(device, readOk);
 }
 
 void EntryAttachments::set(const QString& key, const QByteArray& value)
 {
+    set(key, AttachmentPool::instance()->intern(value));
+}
+
+void EntryAttachments::set(const QString& key, const AttachmentPool::Handle& blob)
+{
+    Q_ASSERT(blob);
+
     bool emitModified = false;
     bool addAttachment = !m_attachments.contains(key);
 
@@ -56,8 +119,8 @@ void EntryAttachments::set(const QString& key, const QByteArray& value)
         emit aboutToBeAdded(key);
     }
 
-    if (addAttachment || m_attachments.value(key) != value) {
-        m_attachments.insert(key, value);
+    if (addAttachment || m_attachments.value(key) != blob) {
+        m_attachments.insert(key, blob);
         emitModified = true;
     }
 
@@ -124,8 +187,7 @@ bool EntryAttachments::rename(const QString& key, const QString& newName) {
 
     if (newName != key) {
         isModified = true;
-        QByteArray data = m_attachments.take(key);
-        m_attachments.insert(newName, data);
+        m_attachments.insert(newName, m_attachments.take(key));
     }
 
     if (isModified) emit entryAttachmentsModified();
@@ -177,7 +239,7 @@ int EntryAttachments::attachmentsSize() const
 {
     int size = 0;
     for (auto it = m_attachments.constBegin(); it != m_attachments.constEnd(); ++it) {
-        size += it.key().toUtf8().size() + it.value().size();
+        size += it.key().toUtf8().size() + it.value()->size();
     }
     return size;
 }
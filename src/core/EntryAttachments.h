@@ -21,6 +21,9 @@
 #include <QMap>
 #include <QObject>
 
+#include "core/AttachmentPool.h"
+
+class QIODevice;
 class QStringList;
 
 class EntryAttachments : public QObject
@@ -32,8 +35,12 @@ public:
     QList<QString> keys() const;
     bool hasKey(const QString& key) const;
     QSet<QByteArray> values() const;
-    QByteArray value(const QString& key) const;
+    QByteArray value(const QString& key, bool* ok = nullptr) const;
+    QByteArray digest(const QString& key) const;
+    int size(const QString& key) const;
+    bool writeToDevice(const QString& key, QIODevice* device, bool* readOk = nullptr) const;
     void set(const QString& key, const QByteArray& value);
+    void set(const QString& key, const AttachmentPool::Handle& blob);
     void remove(const QString& key);
     void remove(const QStringList& keys);
     bool rename(const QString& key, const QString& newName);
@@ -55,7 +62,7 @@ signals:
     void reset();
 
 private:
-    QMap<QString, QByteArray> m_attachments;
+    QMap<QString, AttachmentPool::Handle> m_attachments;
 };
 
 #endif // KEEPASSX_ENTRYATTACHMENTS_H
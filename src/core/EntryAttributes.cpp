@@ -20,6 +20,11 @@
 
 #include "core/Global.h"
 
+#include <QMutex>
+#include <QSet>
+
+#include <algorithm>
+
 const QString EntryAttributes::TitleKey = "Title";
 const QString EntryAttributes::UserNameKey = "UserName";
 const QString EntryAttributes::PasswordKey = "Password";
@@ -34,98 +39,280 @@ const QString EntryAttributes::SearchTextGroupName = "SearchText";
 
 const QString EntryAttributes::RememberCmdExecAttr = "_EXEC_CMD";
 
+namespace
+{
+    // Slots of DefaultAttributes in key order, keys() has to list them sorted like a QMap would
+    const int SortedDefaultSlots[] = {4, 2, 0, 3, 1};
+    const int DefaultAttributeCount = 5;
+} // namespace
+
 EntryAttributes::EntryAttributes(QObject* parent)
     : QObject(parent)
+    , m_data(emptyData())
+{
+}
+
+/**
+ * @return storage block holding only empty default attributes, shared by
+ *         all freshly created or cleared instances until they are modified
+ */
+QSharedDataPointer<EntryAttributes::AttributeData> EntryAttributes::emptyData()
+{
+    static const QSharedDataPointer<AttributeData> empty = [] {
+        QSharedDataPointer<AttributeData> data(new AttributeData());
+        for (auto& defaultValue : data->defaultValues) {
+            defaultValue = "";
+        }
+        return data;
+    }();
+    return empty;
+}
+
+bool EntryAttributes::CustomAttribute::operator==(const CustomAttribute& other) const
+{
+    return key == other.key && value == other.value && isProtected == other.isProtected;
+}
+
+bool EntryAttributes::CustomAttribute::operator!=(const CustomAttribute& other) const
+{
+    return !(*this == other);
+}
+
+/**
+ * @return slot of a default attribute in DefaultAttributes, -1 for custom keys
+ */
+int EntryAttributes::defaultIndex(const QString& key)
+{
+    switch (key.size()) {
+    case 3:
+        return key == URLKey ? 3 : -1;
+    case 5:
+        return key == TitleKey ? 0 : (key == NotesKey ? 4 : -1);
+    case 8:
+        return key == UserNameKey ? 1 : (key == PasswordKey ? 2 : -1);
+    default:
+        return -1;
+    }
+}
+
+namespace
+{
+    QMutex internedKeysMutex;
+    QSet<QString> internedKeys;
+} // namespace
+
+/**
+ * Return a shared copy of an attribute key so every entry and
+ * history item using the same custom key references one buffer.
+ * Only the key names are kept, never attribute values.
+ */
+QString EntryAttributes::internKey(const QString& key)
+{
+    QMutexLocker locker(&internedKeysMutex);
+    auto it = internedKeys.constFind(key);
+    if (it != internedKeys.constEnd()) {
+        return *it;
+    }
+    internedKeys.insert(key);
+    return key;
+}
+
+/**
+ * Forget interned keys which no attribute references anymore, so the
+ * key names of a locked or closed database do not linger in memory.
+ *
+ * @return number of released keys
+ */
+int EntryAttributes::releaseUnusedKeys()
+{
+    QMutexLocker locker(&internedKeysMutex);
+    int released = 0;
+    for (auto it = internedKeys.begin(); it != internedKeys.end();) {
+        // New references are only handed out under the lock, a detached key is held by the table alone
+        if (it->isDetached()) {
+            it = internedKeys.erase(it);
+            ++released;
+        } else {
+            ++it;
+        }
+    }
+    return released;
+}
+
+QVector<EntryAttributes::CustomAttribute>::const_iterator EntryAttributes::findCustom(const QString& key) const
 {
-    clear();
+    return std::lower_bound(m_data->customAttributes.constBegin(),
+                            m_data->customAttributes.constEnd(),
+                            key,
+                            [](const CustomAttribute& attribute, const QString& k) { return attribute.key < k; });
+}
+
+QVector<EntryAttributes::CustomAttribute>::iterator EntryAttributes::findCustom(const QString& key)
+{
+    return std::lower_bound(m_data->customAttributes.begin(),
+                            m_data->customAttributes.end(),
+                            key,
+                            [](const CustomAttribute& attribute, const QString& k) { return attribute.key < k; });
+}
+
+/**
+ * @return pointer to the value stored for key or nullptr if there is none
+ */
+const QString* EntryAttributes::find(const QString& key) const
+{
+    int index = defaultIndex(key);
+    if (index >= 0) {
+        return &m_data->defaultValues[index];
+    }
+
+    auto it = findCustom(key);
+    if (it != m_data->customAttributes.constEnd() && it->key == key) {
+        return &it->value;
+    }
+    return nullptr;
 }
 
 QList<QString> EntryAttributes::keys() const
 {
-    return m_attributes.keys();
+    QList<QString> keys;
+    keys.reserve(DefaultAttributeCount + m_data->customAttributes.size());
+
+    int defaultSlot = 0;
+    for (const auto& attribute : m_data->customAttributes) {
+        while (defaultSlot < DefaultAttributeCount
+               && DefaultAttributes.at(SortedDefaultSlots[defaultSlot]) < attribute.key) {
+            keys.append(DefaultAttributes.at(SortedDefaultSlots[defaultSlot++]));
+        }
+        keys.append(attribute.key);
+    }
+    while (defaultSlot < DefaultAttributeCount) {
+        keys.append(DefaultAttributes.at(SortedDefaultSlots[defaultSlot++]));
+    }
+
+    return keys;
 }
 
 bool EntryAttributes::hasKey(const QString& key) const
 {
-    return m_attributes.contains(key);
+    return find(key) != nullptr;
 }
 
 QList<QString> EntryAttributes::customKeys() const
 {
     QList<QString> customKeys;
-    const QList<QString> keyList = keys();
-    for (const QString& key : keyList) {
-        if (!isDefaultAttribute(key)) {
-            customKeys.append(key);
-        }
+    customKeys.reserve(m_data->customAttributes.size());
+    for (const auto& attribute : m_data->customAttributes) {
+        customKeys.append(attribute.key);
     }
     return customKeys;
 }
 
 QString EntryAttributes::value(const QString& key) const
 {
-    return m_attributes.value(key);
+    const QString* value = find(key);
+    return value ? *value : QString();
 }
 
 QList<QString> EntryAttributes::values(const QList<QString>& keys) const
 {
     QList<QString> values;
     for (const QString& key : keys) {
-        values.append(m_attributes.value(key));
+        values.append(value(key));
     }
     return values;
 }
 
 bool EntryAttributes::contains(const QString& key) const
 {
-    return m_attributes.contains(key);
+    return find(key) != nullptr;
 }
 
 bool EntryAttributes::containsValue(const QString& value) const
 {
-    return asConst(m_attributes).values().contains(value);
+    for (const auto& defaultValue : m_data->defaultValues) {
+        if (defaultValue == value) {
+            return true;
+        }
+    }
+    for (const auto& attribute : m_data->customAttributes) {
+        if (attribute.value == value) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool EntryAttributes::isProtected(const QString& key) const
 {
-    return m_protectedAttributes.contains(key);
+    int index = defaultIndex(key);
+    if (index >= 0) {
+        return m_data->protectedDefaults & (1 << index);
+    }
+
+    auto it = findCustom(key);
+    return it != m_data->customAttributes.constEnd() && it->key == key && it->isProtected;
 }
 
 bool EntryAttributes::isReference(const QString& key) const
 {
-    if (!m_attributes.contains(key)) {
+    const QString* data = find(key);
+    if (!data) {
         Q_ASSERT(false);
         return false;
     }
 
-    const QString data = value(key);
-    return matchReference(data).hasMatch();
+    return matchReference(*data).hasMatch();
 }
 
 void EntryAttributes::set(const QString& key, const QString& value, bool protect)
 {
     bool emitModified = false;
 
-    bool addAttribute = !m_attributes.contains(key);
-    bool changeValue = !addAttribute && (m_attributes.value(key) != value);
-    bool defaultAttribute = isDefaultAttribute(key);
+    int index = defaultIndex(key);
+    bool defaultAttribute = index >= 0;
+    bool addAttribute = !defaultAttribute && !hasKey(key);
+    bool changeValue = false;
 
-    if (addAttribute && !defaultAttribute) {
+    if (addAttribute) {
         emit aboutToBeAdded(key);
     }
 
-    if (addAttribute || changeValue) {
-        m_attributes.insert(key, value);
-        emitModified = true;
-    }
+    if (defaultAttribute) {
+        // Compare through the const block first, unchanged values must not detach shared storage
+        changeValue = m_data.constData()->defaultValues[index] != value;
+        if (changeValue) {
+            m_data->defaultValues[index] = value;
+            emitModified = true;
+        }
 
-    if (protect) {
-        if (!m_protectedAttributes.contains(key)) {
+        const quint8 bit = 1 << index;
+        if (protect != bool(m_data.constData()->protectedDefaults & bit)) {
+            m_data->protectedDefaults ^= bit;
             emitModified = true;
         }
-        m_protectedAttributes.insert(key);
-    } else if (m_protectedAttributes.remove(key)) {
-        emitModified = true;
+    } else {
+        const auto* self = this;
+        auto existing = self->findCustom(key);
+        if (existing != m_data.constData()->customAttributes.constEnd() && existing->key == key
+            && existing->value == value && existing->isProtected == protect) {
+            return;
+        }
+
+        auto it = findCustom(key);
+        if (it == m_data->customAttributes.end() || it->key != key) {
+            it = m_data->customAttributes.insert(it, {internKey(key), value, protect});
+            emitModified = true;
+        } else {
+            changeValue = it->value != value;
+            if (changeValue) {
+                it->value = value;
+                emitModified = true;
+            }
+            if (it->isProtected != protect) {
+                it->isProtected = protect;
+                emitModified = true;
+            }
+        }
     }
 
     if (emitModified) {
@@ -145,14 +332,16 @@ void EntryAttributes::remove(const QString& key)
 {
     Q_ASSERT(!isDefaultAttribute(key));
 
-    if (!m_attributes.contains(key)) {
+    if (isDefaultAttribute(key) || !contains(key)) {
         return;
     }
 
     emit aboutToBeRemoved(key);
 
-    m_attributes.remove(key);
-    m_protectedAttributes.remove(key);
+    auto it = findCustom(key);
+    if (it != m_data->customAttributes.end() && it->key == key) {
+        m_data->customAttributes.erase(it);
+    }
 
     emit removed(key);
     emit entryAttributesModified();
@@ -163,12 +352,12 @@ void EntryAttributes::rename(const QString& oldKey, const QString& newKey)
     Q_ASSERT(!isDefaultAttribute(oldKey));
     Q_ASSERT(!isDefaultAttribute(newKey));
 
-    if (!m_attributes.contains(oldKey)) {
+    if (isDefaultAttribute(oldKey) || !contains(oldKey)) {
         Q_ASSERT(false);
         return;
     }
 
-    if (m_attributes.contains(newKey)) {
+    if (contains(newKey)) {
         Q_ASSERT(false);
         return;
     }
@@ -178,12 +367,8 @@ void EntryAttributes::rename(const QString& oldKey, const QString& newKey)
 
     emit aboutToRename(oldKey, newKey);
 
-    m_attributes.remove(oldKey);
-    m_attributes.insert(newKey, data);
-    if (protect) {
-        m_protectedAttributes.remove(oldKey);
-        m_protectedAttributes.insert(newKey);
-    }
+    m_data->customAttributes.erase(findCustom(oldKey));
+    m_data->customAttributes.insert(findCustom(newKey), {internKey(newKey), data, protect});
 
     emit entryAttributesModified();
     emit renamed(oldKey, newKey);
@@ -197,48 +382,19 @@ void EntryAttributes::copyCustomKeysFrom(const EntryAttributes* other)
 
     emit aboutToBeReset();
 
-    // remove all non-default keys
-    const QList<QString> keyList = keys();
-    for (const QString& key : keyList) {
-        if (!isDefaultAttribute(key)) {
-            m_attributes.remove(key);
-            m_protectedAttributes.remove(key);
-        }
-    }
-
-    const QList<QString> otherKeyList = other->keys();
-    for (const QString& key : otherKeyList) {
-        if (!isDefaultAttribute(key)) {
-            m_attributes.insert(key, other->value(key));
-            if (other->isProtected(key)) {
-                m_protectedAttributes.insert(key);
-            }
-        }
-    }
+    m_data->customAttributes = other->m_data->customAttributes;
 
     emit reset();
     emit entryAttributesModified();
 }
 
-bool EntryAttributes::areCustomKeysDifferent(const EntryAttributes* other)
+bool EntryAttributes::areCustomKeysDifferent(const EntryAttributes* other) const
 {
-    // check if they are equal ignoring the order of the keys
-    if (keys().toSet() != other->keys().toSet()) {
-        return true;
-    }
-
-    const QList<QString> keyList = keys();
-    for (const QString& key : keyList) {
-        if (isDefaultAttribute(key)) {
-            continue;
-        }
-
-        if (isProtected(key) != other->isProtected(key) || value(key) != other->value(key)) {
-            return true;
-        }
+    if (m_data == other->m_data) {
+        return false;
     }
-
-    return false;
+    // both lists are sorted by key, so this ignores the insertion order
+    return m_data->customAttributes != other->m_data->customAttributes;
 }
 
 void EntryAttributes::copyDataFrom(const EntryAttributes* other)
@@ -246,22 +402,61 @@ void EntryAttributes::copyDataFrom(const EntryAttributes* other)
     if (*this != *other) {
         emit aboutToBeReset();
 
-        m_attributes = other->m_attributes;
-        m_protectedAttributes = other->m_protectedAttributes;
+        m_data = other->m_data;
 
         emit reset();
         emit entryAttributesModified();
     }
 }
 
+/**
+ * Make values that are equal to the ones in other share their
+ * storage. The content does not change, so no signals are emitted.
+ *
+ * @param other attributes of another version of the same entry
+ */
+void EntryAttributes::shareValuesWith(const EntryAttributes* other)
+{
+    // A block that is already shared saves more than sharing single values, never detach it
+    if (m_data == other->m_data || m_data.constData()->ref.load() > 1) {
+        return;
+    }
+
+    const AttributeData& data = *m_data.constData();
+    const AttributeData& otherData = *other->m_data.constData();
+    for (int i = 0; i < DefaultAttributeCount; ++i) {
+        const QString& value = data.defaultValues[i];
+        if (!value.isSharedWith(otherData.defaultValues[i]) && value == otherData.defaultValues[i]) {
+            m_data->defaultValues[i] = otherData.defaultValues[i];
+        }
+    }
+
+    // Both lists are sorted by key
+    auto otherIt = otherData.customAttributes.constBegin();
+    for (int i = 0; i < data.customAttributes.size(); ++i) {
+        const CustomAttribute& attribute = data.customAttributes.at(i);
+        while (otherIt != otherData.customAttributes.constEnd() && otherIt->key < attribute.key) {
+            ++otherIt;
+        }
+        if (otherIt == otherData.customAttributes.constEnd()) {
+            break;
+        }
+        if (otherIt->key == attribute.key && !attribute.value.isSharedWith(otherIt->value)
+            && otherIt->value == attribute.value) {
+            m_data->customAttributes[i].value = otherIt->value;
+        }
+    }
+}
+
 QUuid EntryAttributes::referenceUuid(const QString& key) const
 {
-    if (!m_attributes.contains(key)) {
+    const QString* data = find(key);
+    if (!data) {
         Q_ASSERT(false);
         return {};
     }
 
-    auto match = matchReference(value(key));
+    auto match = matchReference(*data);
     if (match.hasMatch()) {
         const QString uuid = match.captured("SearchText");
         if (!uuid.isEmpty()) {
@@ -274,12 +469,21 @@ QUuid EntryAttributes::referenceUuid(const QString& key) const
 
 bool EntryAttributes::operator==(const EntryAttributes& other) const
 {
-    return (m_attributes == other.m_attributes && m_protectedAttributes == other.m_protectedAttributes);
+    if (m_data == other.m_data) {
+        return true;
+    }
+
+    const AttributeData* data = m_data.constData();
+    const AttributeData* otherData = other.m_data.constData();
+    return data->protectedDefaults == otherData->protectedDefaults
+           && std::equal(
+               std::begin(data->defaultValues), std::end(data->defaultValues), std::begin(otherData->defaultValues))
+           && data->customAttributes == otherData->customAttributes;
 }
 
 bool EntryAttributes::operator!=(const EntryAttributes& other) const
 {
-    return (m_attributes != other.m_attributes || m_protectedAttributes != other.m_protectedAttributes);
+    return !(*this == other);
 }
 
 QRegularExpressionMatch EntryAttributes::matchReference(const QString& text)
@@ -295,12 +499,7 @@ void EntryAttributes::clear()
 {
     emit aboutToBeReset();
 
-    m_attributes.clear();
-    m_protectedAttributes.clear();
-
-    for (const QString& key : DefaultAttributes) {
-        m_attributes.insert(key, "");
-    }
+    m_data = emptyData();
 
     emit reset();
     emit entryAttributesModified();
@@ -309,13 +508,16 @@ void EntryAttributes::clear()
 int EntryAttributes::attributesSize() const
 {
     int size = 0;
-    for (auto it = m_attributes.constBegin(); it != m_attributes.constEnd(); ++it) {
-        size += it.key().toUtf8().size() + it.value().toUtf8().size();
+    for (int i = 0; i < DefaultAttributeCount; ++i) {
+        size += DefaultAttributes.at(i).toUtf8().size() + m_data->defaultValues[i].toUtf8().size();
+    }
+    for (const auto& attribute : m_data->customAttributes) {
+        size += attribute.key.toUtf8().size() + attribute.value.toUtf8().size();
     }
     return size;
 }
 
 bool EntryAttributes::isDefaultAttribute(const QString& key)
 {
-    return DefaultAttributes.contains(key);
+    return defaultIndex(key) >= 0;
 }
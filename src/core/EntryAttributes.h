@@ -19,12 +19,12 @@
 #ifndef KEEPASSX_ENTRYATTRIBUTES_H
 #define KEEPASSX_ENTRYATTRIBUTES_H
 
-#include <QMap>
 #include <QObject>
 #include <QRegularExpression>
-#include <QSet>
+#include <QSharedDataPointer>
 #include <QStringList>
 #include <QUuid>
+#include <QVector>
 
 class EntryAttributes : public QObject
 {
@@ -45,10 +45,11 @@ public:
     void remove(const QString& key);
     void rename(const QString& oldKey, const QString& newKey);
     void copyCustomKeysFrom(const EntryAttributes* other);
-    bool areCustomKeysDifferent(const EntryAttributes* other);
+    bool areCustomKeysDifferent(const EntryAttributes* other) const;
     void clear();
     int attributesSize() const;
     void copyDataFrom(const EntryAttributes* other);
+    void shareValuesWith(const EntryAttributes* other);
     QUuid referenceUuid(const QString& key) const;
     bool operator==(const EntryAttributes& other) const;
     bool operator!=(const EntryAttributes& other) const;
@@ -63,6 +64,7 @@ public:
     static const QStringList DefaultAttributes;
     static const QString RememberCmdExecAttr;
     static bool isDefaultAttribute(const QString& key);
+    static int releaseUnusedKeys();
 
     static const QString WantedFieldGroupName;
     static const QString SearchInGroupName;
@@ -82,8 +84,34 @@ signals:
     void reset();
 
 private:
-    QMap<QString, QString> m_attributes;
-    QSet<QString> m_protectedAttributes;
+    struct CustomAttribute
+    {
+        QString key;
+        QString value;
+        bool isProtected;
+
+        bool operator==(const CustomAttribute& other) const;
+        bool operator!=(const CustomAttribute& other) const;
+    };
+
+    // Implicitly shared so clones and history snapshots only copy on write
+    struct AttributeData : public QSharedData
+    {
+        // Default attributes always exist, they live in fixed slots in DefaultAttributes order
+        QString defaultValues[5];
+        quint8 protectedDefaults = 0;
+        // Custom attributes sorted by key, keys are shared between all entries
+        QVector<CustomAttribute> customAttributes;
+    };
+
+    static int defaultIndex(const QString& key);
+    static QString internKey(const QString& key);
+    static QSharedDataPointer<AttributeData> emptyData();
+    QVector<CustomAttribute>::const_iterator findCustom(const QString& key) const;
+    QVector<CustomAttribute>::iterator findCustom(const QString& key);
+    const QString* find(const QString& key) const;
+
+    QSharedDataPointer<AttributeData> m_data;
 };
 
 #endif // KEEPASSX_ENTRYATTRIBUTES_H
@@ -71,15 +71,18 @@ QList<Entry*> EntrySearcher::repeat(const Group* baseGroup, bool forceSearch)
     Q_ASSERT(baseGroup);
 
     QList<Entry*> results;
-    for (const auto group : baseGroup->groupsRecursive(true)) {
-        if (forceSearch || group->resolveSearchingEnabled()) {
-            for (auto* entry : group->entries()) {
-                if (searchEntryImpl(entry)) {
-                    results.append(entry);
+    baseGroup->walkGroups(
+        [&](const Group* group) {
+            if (forceSearch || group->resolveSearchingEnabled()) {
+                for (auto* entry : group->entries()) {
+                    if (searchEntryImpl(entry)) {
+                        results.append(entry);
+                    }
                 }
             }
-        }
-    }
+            return false;
+        },
+        true);
     return results;
 }
 
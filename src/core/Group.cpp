@@ -562,19 +562,12 @@ const QList<Entry*>& Group::entries() const
 QList<Entry*> Group::entriesRecursive(bool includeHistoryItems) const
 {
     QList<Entry*> entryList;
-
-    entryList.append(m_entries);
-
-    if (includeHistoryItems) {
-        for (Entry* entry : m_entries) {
-            entryList.append(entry->historyItems());
-        }
-    }
-
-    for (Group* group : m_children) {
-        entryList.append(group->entriesRecursive(includeHistoryItems));
-    }
-
+    walkEntries(
+        [&entryList](Entry* entry) {
+            entryList.append(entry);
+            return false;
+        },
+        includeHistoryItems);
     return entryList;
 }
 
@@ -591,18 +584,24 @@ Entry* Group::findEntryByUuid(const QUuid& uuid, bool recursive) const
         return nullptr;
     }
 
-    auto entries = m_entries;
-    if (recursive) {
-        entries = entriesRecursive(false);
+    if (!recursive) {
+        for (auto entry : m_entries) {
+            if (entry->uuid() == uuid) {
+                return entry;
+            }
+        }
+        return nullptr;
     }
 
-    for (auto entry : entries) {
+    Entry* result = nullptr;
+    walkEntries([&](Entry* entry) {
         if (entry->uuid() == uuid) {
-            return entry;
+            result = entry;
+            return true;
         }
-    }
-
-    return nullptr;
+        return false;
+    });
+    return result;
 }
 
 Entry* Group::findEntryByPath(const QString& entryPath)
@@ -617,6 +616,9 @@ Entry* Group::findEntryByPath(const QString& entryPath)
     if (!normalizedEntryPath.startsWith("/") && normalizedEntryPath.contains("/")) {
         normalizedEntryPath = "/" + normalizedEntryPath;
     }
+    if (m_db && m_db->rootGroup() == this) {
+        return m_db->findEntryByIndexedPath(normalizedEntryPath);
+    }
     return findEntryByPathRecursive(normalizedEntryPath, "/");
 }
 
@@ -626,45 +628,48 @@ Entry* Group::findEntryBySearchTerm(const QString& term, EntryReferenceType refe
                "Database::findEntryRecursive",
                "Can't search entry with \"referenceType\" parameter equal to \"Unknown\"");
 
-    const QList<Group*> groups = groupsRecursive(true);
+    if (referenceType == EntryReferenceType::Unknown) {
+        return nullptr;
+    }
+
+    const QUuid uuid =
+        referenceType == EntryReferenceType::QUuid ? QUuid::fromRfc4122(QByteArray::fromHex(term.toLatin1())) : QUuid();
 
-    for (const Group* group : groups) {
+    Entry* result = nullptr;
+    walkEntries([&](Entry* entry) {
         bool found = false;
-        const QList<Entry*>& entryList = group->entries();
-        for (Entry* entry : entryList) {
-            switch (referenceType) {
-            case EntryReferenceType::Unknown:
-                return nullptr;
-            case EntryReferenceType::Title:
-                found = entry->title() == term;
-                break;
-            case EntryReferenceType::UserName:
-                found = entry->username() == term;
-                break;
-            case EntryReferenceType::Password:
-                found = entry->password() == term;
-                break;
-            case EntryReferenceType::Url:
-                found = entry->url() == term;
-                break;
-            case EntryReferenceType::Notes:
-                found = entry->notes() == term;
-                break;
-            case EntryReferenceType::QUuid:
-                found = entry->uuid() == QUuid::fromRfc4122(QByteArray::fromHex(term.toLatin1()));
-                break;
-            case EntryReferenceType::CustomAttributes:
-                found = entry->attributes()->containsValue(term);
-                break;
-            }
-
-            if (found) {
-                return entry;
-            }
+        switch (referenceType) {
+        case EntryReferenceType::Unknown:
+            break;
+        case EntryReferenceType::Title:
+            found = entry->title() == term;
+            break;
+        case EntryReferenceType::UserName:
+            found = entry->username() == term;
+            break;
+        case EntryReferenceType::Password:
+            found = entry->password() == term;
+            break;
+        case EntryReferenceType::Url:
+            found = entry->url() == term;
+            break;
+        case EntryReferenceType::Notes:
+            found = entry->notes() == term;
+            break;
+        case EntryReferenceType::QUuid:
+            found = entry->uuid() == uuid;
+            break;
+        case EntryReferenceType::CustomAttributes:
+            found = entry->attributes()->containsValue(term);
+            break;
         }
-    }
 
-    return nullptr;
+        if (found) {
+            result = entry;
+        }
+        return found;
+    });
+    return result;
 }
 
 Entry* Group::findEntryByPathRecursive(const QString& entryPath, const QString& basePath)
@@ -704,6 +709,9 @@ Group* Group::findGroupByPath(const QString& groupPath)
             + (groupPath.endsWith("/") ? "" : "/");
         // clang-format on
     }
+    if (m_db && m_db->rootGroup() == this) {
+        return m_db->findGroupByIndexedPath(normalizedGroupPath);
+    }
     return findGroupByPathRecursive(normalizedGroupPath, "/");
 }
 
@@ -765,28 +773,24 @@ QString Group::print(bool recursive, bool flatten, int depth)
 QList<const Group*> Group::groupsRecursive(bool includeSelf) const
 {
     QList<const Group*> groupList;
-    if (includeSelf) {
-        groupList.append(this);
-    }
-
-    for (const Group* group : asConst(m_children)) {
-        groupList.append(group->groupsRecursive(true));
-    }
-
+    walkGroups(
+        [&groupList](const Group* group) {
+            groupList.append(group);
+            return false;
+        },
+        includeSelf);
     return groupList;
 }
 
 QList<Group*> Group::groupsRecursive(bool includeSelf)
 {
     QList<Group*> groupList;
-    if (includeSelf) {
-        groupList.append(this);
-    }
-
-    for (Group* group : asConst(m_children)) {
-        groupList.append(group->groupsRecursive(true));
-    }
-
+    walkGroups(
+        [&groupList](Group* group) {
+            groupList.append(group);
+            return false;
+        },
+        includeSelf);
     return groupList;
 }
 
@@ -794,20 +798,23 @@ QSet<QUuid> Group::customIconsRecursive() const
 {
     QSet<QUuid> result;
 
-    if (!iconUuid().isNull()) {
-        result.insert(iconUuid());
-    }
-
-    const QList<Entry*> entryList = entriesRecursive(true);
-    for (Entry* entry : entryList) {
-        if (!entry->iconUuid().isNull()) {
-            result.insert(entry->iconUuid());
-        }
-    }
+    walkGroups(
+        [&result](const Group* group) {
+            if (!group->iconUuid().isNull()) {
+                result.insert(group->iconUuid());
+            }
+            return false;
+        },
+        true);
 
-    for (Group* group : m_children) {
-        result.unite(group->customIconsRecursive());
-    }
+    walkEntries(
+        [&result](const Entry* entry) {
+            if (!entry->iconUuid().isNull()) {
+                result.insert(entry->iconUuid());
+            }
+            return false;
+        },
+        true);
 
     return result;
 }
@@ -816,12 +823,13 @@ QList<QString> Group::usernamesRecursive(int topN) const
 {
     // Collect all usernames and sort for easy counting
     QHash<QString, int> countedUsernames;
-    for (const auto* entry : entriesRecursive()) {
+    walkEntries([&countedUsernames](const Entry* entry) {
         const auto username = entry->username();
         if (!username.isEmpty() && !entry->isAttributeReference(EntryAttributes::UserNameKey)) {
-            countedUsernames.insert(username, ++countedUsernames[username]);
+            ++countedUsernames[username];
         }
-    }
+        return false;
+    });
 
     // Sort username/frequency pairs by frequency and name
     QList<QPair<QString, int>> sortedUsernames;
@@ -854,13 +862,17 @@ Group* Group::findGroupByUuid(const QUuid& uuid)
         return nullptr;
     }
 
-    for (Group* group : groupsRecursive(true)) {
-        if (group->uuid() == uuid) {
-            return group;
-        }
-    }
-
-    return nullptr;
+    Group* result = nullptr;
+    walkGroups(
+        [&](Group* group) {
+            if (group->uuid() == uuid) {
+                result = group;
+                return true;
+            }
+            return false;
+        },
+        true);
+    return result;
 }
 
 Group* Group::findChildByName(const QString& name)
@@ -941,6 +953,7 @@ void Group::addEntry(Entry* entry)
     connect(entry, SIGNAL(entryDataChanged(Entry*)), SIGNAL(entryDataChanged(Entry*)));
     if (m_db) {
         connect(entry, SIGNAL(entryModified()), m_db, SLOT(markAsModified()));
+        m_db->trackEntry(entry);
     }
 
     emit groupModified();
@@ -958,8 +971,9 @@ void Group::removeEntry(Entry* entry)
     entry->disconnect(this);
     if (m_db) {
         entry->disconnect(m_db);
+        m_db->untrackEntry(entry);
     }
-    m_entries.removeAll(entry);
+    m_entries.removeOne(entry);
     emit groupModified();
     emit entryRemoved(entry);
 }
@@ -980,9 +994,11 @@ void Group::connectDatabaseSignalsRecursive(Database* db)
     for (Entry* entry : asConst(m_entries)) {
         if (m_db) {
             entry->disconnect(m_db);
+            m_db->untrackEntry(entry);
         }
         if (db) {
             connect(entry, SIGNAL(entryModified()), db, SLOT(markAsModified()));
+            db->trackEntry(entry);
         }
     }
 
@@ -1010,7 +1026,7 @@ void Group::cleanupParent()
 {
     if (m_parent) {
         emit groupAboutToRemove(this);
-        m_parent->m_children.removeAll(this);
+        m_parent->m_children.removeOne(this);
         emit groupModified();
         emit groupRemoved();
     }
@@ -1030,6 +1046,22 @@ void Group::recCreateDelObjects()
     }
 }
 
+/**
+ * Take this group and everything below it out of the database in one step.
+ * Deleted objects are recorded for the whole subtree, destroying the group
+ * afterwards no longer notifies the database.
+ */
+void Group::detachFromDatabase()
+{
+    Q_ASSERT(m_db && m_parent);
+
+    recCreateDelObjects();
+    cleanupParent();
+    m_parent = nullptr;
+    QObject::setParent(nullptr);
+    connectDatabaseSignalsRecursive(nullptr);
+}
+
 bool Group::resolveSearchingEnabled() const
 {
     switch (m_data.searchingEnabled) {
@@ -1076,6 +1108,16 @@ QStringList Group::locate(const QString& locateTerm, const QString& currentPath)
         return response;
     }
 
+    if (m_db && m_db->rootGroup() == this && currentPath == "/") {
+        const QStringList entryPaths = m_db->indexedEntryPaths();
+        for (const QString& entryPath : entryPaths) {
+            if (entryPath.contains(locateTerm, Qt::CaseInsensitive)) {
+                response << entryPath;
+            }
+        }
+        return response;
+    }
+
     for (const Entry* entry : asConst(m_entries)) {
         QString entryPath = currentPath + entry->title();
         if (entryPath.contains(locateTerm, Qt::CaseInsensitive)) {
@@ -1154,16 +1196,20 @@ void Group::applyGroupIconTo(Group* other)
 
 void Group::applyGroupIconToChildGroups()
 {
-    for (Group* recursiveChild : groupsRecursive(false)) {
-        applyGroupIconTo(recursiveChild);
-    }
+    walkGroups(
+        [this](Group* recursiveChild) {
+            applyGroupIconTo(recursiveChild);
+            return false;
+        },
+        false);
 }
 
 void Group::applyGroupIconToChildEntries()
 {
-    for (Entry* recursiveEntry : entriesRecursive(false)) {
+    walkEntries([this](Entry* recursiveEntry) {
         applyGroupIconTo(recursiveEntry);
-    }
+        return false;
+    });
 }
 
 void Group::sortChildrenRecursively(bool reverse)
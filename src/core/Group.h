@@ -27,6 +27,7 @@
 #include "core/CustomData.h"
 #include "core/Database.h"
 #include "core/Entry.h"
+#include "core/Global.h"
 #include "core/TimeInfo.h"
 
 class Group : public QObject
@@ -156,6 +157,9 @@ public:
     QList<Entry*> entriesRecursive(bool includeHistoryItems = false) const;
     QList<const Group*> groupsRecursive(bool includeSelf) const;
     QList<Group*> groupsRecursive(bool includeSelf);
+    template <typename Visitor> bool walkEntries(Visitor visitor, bool includeHistoryItems = false) const;
+    template <typename Visitor> bool walkGroups(Visitor visitor, bool includeSelf) const;
+    template <typename Visitor> bool walkGroups(Visitor visitor, bool includeSelf);
     QSet<QUuid> customIconsRecursive() const;
     QList<QString> usernamesRecursive(int topN = -1) const;
 
@@ -202,6 +206,7 @@ private:
     void connectDatabaseSignalsRecursive(Database* db);
     void cleanupParent();
     void recCreateDelObjects();
+    void detachFromDatabase();
 
     Entry* findEntryByPathRecursive(const QString& entryPath, const QString& basePath);
     Group* findGroupByPathRecursive(const QString& groupPath, const QString& basePath);
@@ -220,10 +225,86 @@ private:
     bool m_updateTimeinfo;
 
     friend void Database::setRootGroup(Group* group);
+    friend void Database::deleteItems(const QList<Entry*>& entries, const QList<Group*>& groups);
     friend Entry::~Entry();
     friend void Entry::setGroup(Group* group);
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(Group::CloneFlags)
 
+/**
+ * Visit all entries of this group and its children in the order of
+ * entriesRecursive() without building a list. The visitor must not
+ * add or remove entries or groups.
+ *
+ * @param visitor callable taking an Entry*, returns true to stop the walk
+ * @param includeHistoryItems also visit the history items of every entry
+ * @return true if the visitor stopped the walk
+ */
+template <typename Visitor> bool Group::walkEntries(Visitor visitor, bool includeHistoryItems) const
+{
+    for (Entry* entry : m_entries) {
+        if (visitor(entry)) {
+            return true;
+        }
+    }
+
+    if (includeHistoryItems) {
+        for (const Entry* entry : m_entries) {
+            for (Entry* historyItem : entry->historyItems()) {
+                if (visitor(historyItem)) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    for (const Group* group : m_children) {
+        if (group->walkEntries(visitor, includeHistoryItems)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Visit this group's descendants depth first in the order of
+ * groupsRecursive() without building a list. The visitor must not
+ * add or remove groups.
+ *
+ * @param visitor callable taking a const Group*, returns true to stop the walk
+ * @param includeSelf also visit this group first
+ * @return true if the visitor stopped the walk
+ */
+template <typename Visitor> bool Group::walkGroups(Visitor visitor, bool includeSelf) const
+{
+    if (includeSelf && visitor(this)) {
+        return true;
+    }
+
+    for (const Group* group : m_children) {
+        if (group->walkGroups(visitor, true)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template <typename Visitor> bool Group::walkGroups(Visitor visitor, bool includeSelf)
+{
+    if (includeSelf && visitor(this)) {
+        return true;
+    }
+
+    for (Group* group : asConst(m_children)) {
+        if (group->walkGroups(visitor, true)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 #endif // KEEPASSX_GROUP_H
@@ -80,12 +80,13 @@ namespace HibpOffline
     report(QSharedPointer<Database> db, QIODevice& hibpInput, QList<QPair<const Entry*, int>>& findings, QString* error)
     {
         QMultiHash<QByteArray, const Entry*> entriesBySha1;
-        for (const auto* entry : db->rootGroup()->entriesRecursive()) {
+        db->rootGroup()->walkEntries([&entriesBySha1](const Entry* entry) {
             if (!entry->isRecycled()) {
                 const auto sha1 = QCryptographicHash::hash(entry->password().toUtf8(), QCryptographicHash::Sha1);
                 entriesBySha1.insert(sha1, entry);
             }
-        }
+            return false;
+        });
 
         QByteArray sha1;
         for (quint64 lineNum = 1;; ++lineNum) {
@@ -20,8 +20,12 @@
 #include "core/Clock.h"
 #include "core/Database.h"
 #include "core/Entry.h"
+#include "core/Global.h"
 #include "core/Metadata.h"
 
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
 Merger::Merger(const Database* sourceDb, Database* targetDb)
     : m_mode(Group::Default)
 {
@@ -62,12 +66,36 @@ void Merger::resetForcedMergeMode()
 
 QStringList Merger::merge()
 {
+    // Views refresh once after the merge instead of following every single change
+    Database::BulkUpdate bulkUpdate(m_context.m_targetDb);
+
+    m_statistics = Statistics();
+    QElapsedTimer timer;
+    timer.start();
+
+    buildIndex(m_context);
+    m_statistics.indexTime = timer.restart();
+    planEntries(m_context);
+    m_statistics.planTime = timer.restart();
+
+    // Erased items leave deletedObjects behind, drop them all at once
+    // after merging instead of restoring the list on every single erase
+    const QList<DeletedObject> deletions = m_context.m_targetDb->deletedObjects();
+
     // Order of merge steps is important - it is possible that we
     // create some items before deleting them afterwards
     ChangeList changes;
     changes << mergeGroup(m_context);
+    m_context.m_targetDb->setDeletedObjects(deletions);
+    m_statistics.groupTime = timer.restart();
     changes << mergeDeletions(m_context);
+    m_statistics.deletionTime = timer.restart();
     changes << mergeMetadata(m_context);
+    m_statistics.metadataTime = timer.elapsed();
+
+    m_targetEntries.clear();
+    m_targetGroups.clear();
+    m_plan.clear();
 
     // qDebug("Merged %s", qPrintable(changes.join("\n\t")));
 
@@ -78,18 +106,120 @@ QStringList Merger::merge()
     return changes;
 }
 
+/**
+ * @return item counts and elapsed milliseconds of each phase of the last merge
+ */
+const Merger::Statistics& Merger::statistics() const
+{
+    return m_statistics;
+}
+
+void Merger::buildIndex(const MergeContext& context)
+{
+    m_targetEntries.clear();
+    m_targetGroups.clear();
+
+    // Keep the first match for duplicated uuids, like Group::findEntryByUuid does
+    const QList<Entry*> entries = context.m_targetRootGroup->entriesRecursive(false);
+    m_targetEntries.reserve(entries.size());
+    for (Entry* entry : entries) {
+        if (!entry->uuid().isNull() && !m_targetEntries.contains(entry->uuid())) {
+            m_targetEntries.insert(entry->uuid(), entry);
+        }
+    }
+
+    const QList<Group*> groups = context.m_targetRootGroup->groupsRecursive(true);
+    m_targetGroups.reserve(groups.size());
+    for (Group* group : groups) {
+        if (!group->uuid().isNull() && !m_targetGroups.contains(group->uuid())) {
+            m_targetGroups.insert(group->uuid(), group);
+        }
+    }
+}
+
+/**
+ * Compare every source entry with its counterpart in the target before anything
+ * is modified. The comparisons only read both entries and run in parallel, so
+ * mergeGroup can skip the unchanged entries and only resolves the others.
+ */
+void Merger::planEntries(const MergeContext& context)
+{
+    m_plan.clear();
+
+    QVector<PlannedEntry> plan;
+    QSet<const Entry*> plannedTargets;
+    const QList<Entry*> sourceEntries = context.m_sourceGroup->entriesRecursive(false);
+    plan.reserve(sourceEntries.size());
+    for (const Entry* sourceEntry : sourceEntries) {
+        Entry* targetEntry = findTargetEntry(sourceEntry->uuid());
+        // Each job may only touch its own entries, comparing them caches their digests
+        if (targetEntry && !plannedTargets.contains(targetEntry)) {
+            plannedTargets.insert(targetEntry);
+            PlannedEntry planned;
+            planned.sourceEntry = sourceEntry;
+            planned.targetEntry = targetEntry;
+            plan.append(planned);
+        }
+    }
+
+    QtConcurrent::blockingMap(plan, [](PlannedEntry& planned) {
+        planned.unchanged = isEntryUnchanged(planned.sourceEntry, planned.targetEntry);
+    });
+
+    m_plan.reserve(plan.size());
+    for (const PlannedEntry& planned : asConst(plan)) {
+        m_plan.insert(planned.sourceEntry, planned);
+    }
+}
+
+bool Merger::isEntryUnchanged(const Entry* sourceEntry, const Entry* targetEntry)
+{
+    if (compare(targetEntry->timeInfo().lastModificationTime(),
+                sourceEntry->timeInfo().lastModificationTime(),
+                CompareItemIgnoreMilliseconds)
+        != 0) {
+        return false;
+    }
+    // Relocation is handled separately by mergeGroup
+    if (!targetEntry->equals(sourceEntry, CompareItemIgnoreMilliseconds | CompareItemIgnoreLocation)) {
+        return false;
+    }
+    // mergeHistory rewrites histories which are not strictly ordered, leave those to it
+    QDateTime previous;
+    for (const Entry* historyItem : targetEntry->historyItems()) {
+        const QDateTime modificationTime = Clock::serialized(historyItem->timeInfo().lastModificationTime());
+        if (previous.isValid() && modificationTime <= previous) {
+            return false;
+        }
+        previous = modificationTime;
+    }
+    return true;
+}
+
+Entry* Merger::findTargetEntry(const QUuid& uuid) const
+{
+    return m_targetEntries.value(uuid, nullptr);
+}
+
+Group* Merger::findTargetGroup(const QUuid& uuid) const
+{
+    return m_targetGroups.value(uuid, nullptr);
+}
+
 Merger::ChangeList Merger::mergeGroup(const MergeContext& context)
 {
     ChangeList changes;
     // merge entries
     const QList<Entry*> sourceEntries = context.m_sourceGroup->entries();
+    m_statistics.entries += sourceEntries.size();
     for (Entry* sourceEntry : sourceEntries) {
-        Entry* targetEntry = context.m_targetRootGroup->findEntryByUuid(sourceEntry->uuid());
+        Entry* targetEntry = findTargetEntry(sourceEntry->uuid());
         if (!targetEntry) {
             changes << tr("Creating missing %1 [%2]").arg(sourceEntry->title(), sourceEntry->uuidToHex());
             // This entry does not exist at all. Create it.
             targetEntry = sourceEntry->clone(Entry::CloneIncludeHistory);
             moveEntry(targetEntry, context.m_targetGroup);
+            m_targetEntries.insert(targetEntry->uuid(), targetEntry);
         } else {
             // Entry is already present in the database. Update it.
             const bool locationChanged =
@@ -98,18 +228,27 @@ Merger::ChangeList Merger::mergeGroup(const MergeContext& context)
                 changes << tr("Relocating %1 [%2]").arg(sourceEntry->title(), sourceEntry->uuidToHex());
                 moveEntry(targetEntry, context.m_targetGroup);
             }
+            // The plan is stale if an earlier step replaced the target entry
+            const PlannedEntry planned = m_plan.value(sourceEntry);
+            if (planned.targetEntry == targetEntry && planned.unchanged) {
+                ++m_statistics.unchangedEntries;
+                continue;
+            }
             changes << resolveEntryConflict(context, sourceEntry, targetEntry);
         }
     }
 
     // merge groups recursively
     const QList<Group*> sourceChildGroups = context.m_sourceGroup->children();
+    m_statistics.groups += sourceChildGroups.size();
     for (Group* sourceChildGroup : sourceChildGroups) {
-        Group* targetChildGroup = context.m_targetRootGroup->findGroupByUuid(sourceChildGroup->uuid());
+        Group* targetChildGroup = findTargetGroup(sourceChildGroup->uuid());
         if (!targetChildGroup) {
             changes << tr("Creating missing %1 [%2]").arg(sourceChildGroup->name(), sourceChildGroup->uuidToHex());
+            // The clone carries neither entries nor children, those are merged below
             targetChildGroup = sourceChildGroup->clone(Entry::CloneNoFlags, Group::CloneNoFlags);
             moveGroup(targetChildGroup, context.m_targetGroup);
+            m_targetGroups.insert(targetChildGroup->uuid(), targetChildGroup);
             TimeInfo timeinfo = targetChildGroup->timeInfo();
             timeinfo.setLocationChanged(sourceChildGroup->timeInfo().locationChanged());
             targetChildGroup->setTimeInfo(timeinfo);
@@ -230,9 +369,9 @@ void Merger::moveGroup(Group* group, Group* targetGroup)
 
 void Merger::eraseEntry(Entry* entry)
 {
-    Database* database = entry->database();
-    // most simple method to remove an item from DeletedObjects :(
-    const QList<DeletedObject> deletions = database->deletedObjects();
+    if (m_targetEntries.value(entry->uuid()) == entry) {
+        m_targetEntries.remove(entry->uuid());
+    }
     Group* parentGroup = entry->group();
     const bool groupUpdateTimeInfo = parentGroup ? parentGroup->canUpdateTimeinfo() : false;
     if (parentGroup) {
@@ -242,14 +381,13 @@ void Merger::eraseEntry(Entry* entry)
     if (parentGroup) {
         parentGroup->setUpdateTimeinfo(groupUpdateTimeInfo);
     }
-    database->setDeletedObjects(deletions);
 }
 
 void Merger::eraseGroup(Group* group)
 {
-    Database* database = group->database();
-    // most simple method to remove an item from DeletedObjects :(
-    const QList<DeletedObject> deletions = database->deletedObjects();
+    if (m_targetGroups.value(group->uuid()) == group) {
+        m_targetGroups.remove(group->uuid());
+    }
     Group* parentGroup = group->parentGroup();
     const bool groupUpdateTimeInfo = parentGroup ? parentGroup->canUpdateTimeinfo() : false;
     if (parentGroup) {
@@ -259,7 +397,6 @@ void Merger::eraseGroup(Group* group)
     if (parentGroup) {
         parentGroup->setUpdateTimeinfo(groupUpdateTimeInfo);
     }
-    database->setDeletedObjects(deletions);
 }
 
 Merger::ChangeList
@@ -353,6 +490,7 @@ Merger::ChangeList Merger::resolveEntryConflict_MergeHistories(const MergeContex
         changes << tr("Synchronizing from newer source %1 [%2]").arg(targetEntry->title(), targetEntry->uuidToHex());
         moveEntry(clonedEntry, currentGroup);
         mergeHistory(targetEntry, clonedEntry, mergeMethod);
+        m_targetEntries.insert(clonedEntry->uuid(), clonedEntry);
         eraseEntry(targetEntry);
     } else {
         qDebug("Merge %s/%s with local on top/under %s",
@@ -528,29 +666,36 @@ Merger::ChangeList Merger::mergeDeletions(const MergeContext& context)
     const auto sourceDeletions = context.m_sourceDb->deletedObjects();
 
     QList<DeletedObject> deletions;
-    QMap<QUuid, DeletedObject> mergedDeletions;
+    QHash<QUuid, DeletedObject> mergedDeletions;
     QList<Entry*> entries;
     QList<Group*> groups;
+    // number of child groups of a group which are still waiting in groups
+    QHash<const Group*, int> pendingChildren;
 
+    mergedDeletions.reserve(targetDeletions.size() + sourceDeletions.size());
     for (const auto& object : (targetDeletions + sourceDeletions)) {
-        if (!mergedDeletions.contains(object.uuid)) {
-            mergedDeletions[object.uuid] = object;
+        auto it = mergedDeletions.find(object.uuid);
+        if (it == mergedDeletions.end()) {
+            mergedDeletions.insert(object.uuid, object);
 
-            auto* entry = context.m_targetRootGroup->findEntryByUuid(object.uuid);
+            auto* entry = findTargetEntry(object.uuid);
             if (entry) {
                 entries << entry;
                 continue;
             }
-            auto* group = context.m_targetRootGroup->findGroupByUuid(object.uuid);
+            auto* group = findTargetGroup(object.uuid);
             if (group) {
                 groups << group;
+                if (group->parentGroup()) {
+                    ++pendingChildren[group->parentGroup()];
+                }
                 continue;
             }
             deletions << object;
             continue;
         }
-        if (mergedDeletions[object.uuid].deletionTime > object.deletionTime) {
-            mergedDeletions[object.uuid] = object;
+        if (it->deletionTime > object.deletionTime) {
+            *it = object;
         }
     }
 
@@ -573,17 +718,20 @@ Merger::ChangeList Merger::mergeDeletions(const MergeContext& context)
 
     while (!groups.isEmpty()) {
         auto* group = groups.takeFirst();
-        if (!(group->children().toSet() & groups.toSet()).isEmpty()) {
+        if (pendingChildren.value(group) > 0) {
             // we need to finish all children before we are able to determine if the group can be removed
             groups << group;
             continue;
         }
+        if (group->parentGroup()) {
+            --pendingChildren[group->parentGroup()];
+        }
         const auto& object = mergedDeletions[group->uuid()];
         if (group->timeInfo().lastModificationTime() > object.deletionTime) {
             // keep deleted group since it was changed after deletion date
             continue;
         }
-        if (!group->entriesRecursive(false).isEmpty() || !group->groupsRecursive(false).isEmpty()) {
+        if (!group->entries().isEmpty() || !group->children().isEmpty()) {
             // keep deleted group since it contains undeleted content
             continue;
         }
@@ -596,7 +744,7 @@ Merger::ChangeList Merger::mergeDeletions(const MergeContext& context)
         eraseGroup(group);
     }
     // Put every deletion to the earliest date of deletion
-    if (deletions != context.m_targetDb->deletedObjects()) {
+    if (deletions != targetDeletions) {
         changes << tr("Changed deleted objects");
     }
     context.m_targetDb->setDeletedObjects(deletions);
@@ -19,6 +19,7 @@
 #define KEEPASSXC_MERGER_H
 
 #include "core/Group.h"
+#include <QHash>
 #include <QObject>
 #include <QPointer>
 
@@ -35,6 +36,19 @@ public:
     void resetForcedMergeMode();
     QStringList merge();
 
+    struct Statistics
+    {
+        int entries = 0;
+        int groups = 0;
+        int unchangedEntries = 0;
+        qint64 indexTime = 0;
+        qint64 planTime = 0;
+        qint64 groupTime = 0;
+        qint64 deletionTime = 0;
+        qint64 metadataTime = 0;
+    };
+    const Statistics& statistics() const;
+
 private:
     typedef QString Change;
     typedef QStringList ChangeList;
@@ -48,6 +62,19 @@ private:
         QPointer<const Group> m_sourceGroup;
         QPointer<Group> m_targetGroup;
     };
+    struct PlannedEntry
+    {
+        const Entry* sourceEntry = nullptr;
+        Entry* targetEntry = nullptr;
+        // Entries that are not unchanged go through resolveEntryConflict
+        bool unchanged = false;
+    };
+
+    void buildIndex(const MergeContext& context);
+    void planEntries(const MergeContext& context);
+    static bool isEntryUnchanged(const Entry* sourceEntry, const Entry* targetEntry);
+    Entry* findTargetEntry(const QUuid& uuid) const;
+    Group* findTargetGroup(const QUuid& uuid) const;
     ChangeList mergeGroup(const MergeContext& context);
     ChangeList mergeDeletions(const MergeContext& context);
     ChangeList mergeMetadata(const MergeContext& context);
@@ -55,9 +82,9 @@ private:
     bool mergeHistory(const Entry* sourceEntry, Entry* targetEntry, Group::MergeMode mergeMethod);
     void moveEntry(Entry* entry, Group* targetGroup);
     void moveGroup(Group* group, Group* targetGroup);
-    // remove an entry without a trace in the deletedObjects - needed for elemination cloned entries
+    // remove an entry from the target - merge() drops the deletedObjects it leaves behind
     void eraseEntry(Entry* entry);
-    // remove an entry without a trace in the deletedObjects - needed for elemination cloned entries
+    // remove a group from the target - merge() drops the deletedObjects it leaves behind
     void eraseGroup(Group* group);
     ChangeList resolveEntryConflict(const MergeContext& context, const Entry* existingEntry, Entry* otherEntry);
     ChangeList resolveGroupConflict(const MergeContext& context, const Group* existingGroup, Group* otherGroup);
@@ -75,6 +102,12 @@ private:
 private:
     MergeContext m_context;
     Group::MergeMode m_mode;
+    // target items by uuid, kept in sync while merging to avoid recursive lookups
+    QHash<QUuid, Entry*> m_targetEntries;
+    QHash<QUuid, Group*> m_targetGroups;
+    // comparison results computed up front for every source entry with a counterpart
+    QHash<const Entry*, PlannedEntry> m_plan;
+    Statistics m_statistics;
 };
 
 #endif // KEEPASSXC_MERGER_H
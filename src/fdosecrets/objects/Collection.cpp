@@ -513,6 +513,11 @@ namespace FdoSecrets
             }
         });
 
+        connect(m_backend->database().data(),
+                &Database::bulkUpdateFinished,
+                this,
+                &Collection::onBulkUpdateFinished);
+
         // Monitor exposed group settings
         connect(m_backend->database()->metadata()->customData(), &CustomData::customDataModified, this, [this]() {
             if (!m_exposedGroup || backendLocked()) {
@@ -584,7 +589,7 @@ namespace FdoSecrets
             return;
         }
 
-        connect(group, &Group::groupModified, this, &Collection::collectionChanged);
+        connect(group, &Group::groupModified, this, &Collection::onGroupModified);
         connect(group, &Group::entryAdded, this, [this](Entry* entry) { onEntryAdded(entry, true); });
 
         const auto children = group->children();
@@ -593,6 +598,23 @@ namespace FdoSecrets
         }
     }
 
+    void Collection::onGroupModified()
+    {
+        if (m_backend && m_backend->database()->isBulkUpdating()) {
+            m_collectionChangedPending = true;
+            return;
+        }
+        emit collectionChanged();
+    }
+
+    void Collection::onBulkUpdateFinished()
+    {
+        if (m_collectionChangedPending && m_backend && !m_backend->database()->isBulkUpdating()) {
+            m_collectionChangedPending = false;
+            emit collectionChanged();
+        }
+    }
+
     Service* Collection::service() const
     {
         return qobject_cast<Service*>(parent());
@@ -634,7 +656,9 @@ namespace FdoSecrets
 
     void Collection::cleanupConnections()
     {
+        m_backend->database()->disconnect(this);
         m_backend->database()->metadata()->customData()->disconnect(this);
+        m_collectionChangedPending = false;
         if (m_exposedGroup) {
             for (const auto group : m_exposedGroup->groupsRecursive(true)) {
                 group->disconnect(this);
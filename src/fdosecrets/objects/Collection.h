@@ -113,6 +113,8 @@ namespace FdoSecrets
     private slots:
         void onDatabaseLockChanged();
         void onDatabaseExposedGroupChanged();
+        void onGroupModified();
+        void onBulkUpdateFinished();
         // force reload info from backend, potentially delete self
         void reloadBackend();
 
@@ -156,6 +158,8 @@ namespace FdoSecrets
         QMap<const Entry*, Item*> m_entryToItem;
 
         bool m_registered;
+        // collectionChanged is emitted once after a bulk update instead of per group
+        bool m_collectionChangedPending = false;
     };
 
 } // namespace FdoSecrets
@@ -272,8 +272,9 @@ bool Kdbx4Reader::readInnerHeaderField(QIODevice* device)
             raiseError(tr("Invalid inner header binary size"));
             return false;
         }
-        auto data = fieldData.mid(1);
-        m_binaryPool.insert(QString::number(m_binaryPool.size()), data);
+        // Intern right away so large payloads can be spilled while the rest is read
+        auto blob = AttachmentPool::instance()->intern(fieldData.mid(1));
+        m_binaryPool.insert(QString::number(m_binaryPool.size()), blob);
         break;
     }
     }
@@ -416,7 +417,7 @@ QVariantMap Kdbx4Reader::readVariantMap(QIODevice* device)
 /**
  * @return mapping from attachment keys to binary data
  */
-QHash<QString, QByteArray> Kdbx4Reader::binaryPool() const
+QHash<QString, AttachmentPool::Handle> Kdbx4Reader::binaryPool() const
 {
     return m_binaryPool;
 }
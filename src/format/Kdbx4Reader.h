@@ -18,6 +18,7 @@
 #ifndef KEEPASSX_KDBX4READER_H
 #define KEEPASSX_KDBX4READER_H
 
+#include "core/AttachmentPool.h"
 #include "format/KdbxReader.h"
 
 #include <QVariantMap>
@@ -34,7 +35,7 @@ public:
                           const QByteArray& headerData,
                           QSharedPointer<const CompositeKey> key,
                           Database* db) override;
-    QHash<QString, QByteArray> binaryPool() const;
+    QHash<QString, AttachmentPool::Handle> binaryPool() const;
 
 protected:
     bool readHeaderField(StoreDataStream& headerStream, Database* db) override;
@@ -43,7 +44,7 @@ private:
     bool readInnerHeaderField(QIODevice* device);
     QVariantMap readVariantMap(QIODevice* device);
 
-    QHash<QString, QByteArray> m_binaryPool;
+    QHash<QString, AttachmentPool::Handle> m_binaryPool;
 };
 
 #endif // KEEPASSX_KDBX4READER_H
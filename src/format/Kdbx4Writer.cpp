@@ -161,7 +161,7 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
         writeInnerHeaderField(outputDevice, KeePass2::InnerHeaderFieldID::InnerRandomStreamKey, protectedStreamKey));
 
     // Write attachments to the inner header
-    writeAttachments(outputDevice, db);
+    CHECK_RETURN_FALSE(writeAttachments(outputDevice, db));
 
     CHECK_RETURN_FALSE(writeInnerHeaderField(outputDevice, KeePass2::InnerHeaderFieldID::End, QByteArray()));
 
@@ -216,7 +216,7 @@ bool Kdbx4Writer::writeInnerHeaderField(QIODevice* device, KeePass2::InnerHeader
     return true;
 }
 
-void Kdbx4Writer::writeAttachments(QIODevice* device, Database* db)
+bool Kdbx4Writer::writeAttachments(QIODevice* device, Database* db)
 {
     const QList<Entry*> allEntries = db->rootGroup()->entriesRecursive(true);
     QSet<QByteArray> writtenAttachments;
@@ -224,17 +224,32 @@ void Kdbx4Writer::writeAttachments(QIODevice* device, Database* db)
     for (Entry* entry : allEntries) {
         const QList<QString> attachmentKeys = entry->attachments()->keys();
         for (const QString& key : attachmentKeys) {
-            QByteArray data("\x01");
-            data.append(entry->attachments()->value(key));
-
-            if (writtenAttachments.contains(data)) {
+            const QByteArray digest = entry->attachments()->digest(key);
+            if (writtenAttachments.contains(digest)) {
                 continue;
             }
 
-            writeInnerHeaderField(device, KeePass2::InnerHeaderFieldID::Binary, data);
-            writtenAttachments.insert(data);
+            // Stream the payload so spilled attachments are never fully loaded
+            const int size = entry->attachments()->size(key);
+            QByteArray fieldHeader;
+            fieldHeader.append(static_cast<char>(KeePass2::InnerHeaderFieldID::Binary));
+            fieldHeader.append(Endian::sizedIntToBytes(static_cast<quint32>(size + 1), KeePass2::BYTEORDER));
+            fieldHeader.append('\x01');
+            CHECK_RETURN_FALSE(writeData(device, fieldHeader));
+            bool readOk = true;
+            if (!entry->attachments()->writeToDevice(key, device, &readOk)) {
+                if (readOk) {
+                    raiseError(device->errorString());
+                } else {
+                    raiseError(tr("Unable to read attachment %1 of entry %2").arg(key, entry->title()));
+                }
+                return false;
+            }
+            writtenAttachments.insert(digest);
         }
     }
+
+    return true;
 }
 
 /**
@@ -44,7 +44,7 @@ KdbxXmlReader::KdbxXmlReader(quint32 version)
  * @param version KDBX version
  * @param binaryPool binary pool
  */
-KdbxXmlReader::KdbxXmlReader(quint32 version, QHash<QString, QByteArray> binaryPool)
+KdbxXmlReader::KdbxXmlReader(quint32 version, QHash<QString, AttachmentPool::Handle> binaryPool)
     : m_kdbxVersion(version)
     , m_binaryPool(std::move(binaryPool))
 {
@@ -140,7 +140,12 @@ void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2Random
     QHash<QString, QPair<Entry*, QString>>::const_iterator i;
     for (i = m_binaryMap.constBegin(); i != m_binaryMap.constEnd(); ++i) {
         const QPair<Entry*, QString>& target = i.value();
-        target.first->attachments()->set(target.second, m_binaryPool[i.key()]);
+        const AttachmentPool::Handle blob = m_binaryPool.value(i.key());
+        if (blob) {
+            target.first->attachments()->set(target.second, blob);
+        } else {
+            target.first->attachments()->set(target.second, QByteArray());
+        }
     }
 
     m_meta->setUpdateDatetime(true);
@@ -396,7 +401,7 @@ void KdbxXmlReader::parseBinaries()
             qWarning("KdbxXmlReader::parseBinaries: overwriting binary item \"%s\"", qPrintable(id));
         }
 
-        m_binaryPool.insert(id, data);
+        m_binaryPool.insert(id, AttachmentPool::instance()->intern(data));
     }
 }
 
@@ -18,6 +18,7 @@
 #ifndef KEEPASSXC_KDBXXMLREADER_H
 #define KEEPASSXC_KDBXXMLREADER_H
 
+#include "core/AttachmentPool.h"
 #include "core/Database.h"
 #include "core/Metadata.h"
 #include "core/TimeInfo.h"
@@ -41,7 +42,7 @@ class KdbxXmlReader
 
 public:
     explicit KdbxXmlReader(quint32 version);
-    explicit KdbxXmlReader(quint32 version, QHash<QString, QByteArray> binaryPool);
+    explicit KdbxXmlReader(quint32 version, QHash<QString, AttachmentPool::Handle> binaryPool);
     virtual ~KdbxXmlReader() = default;
 
     virtual QSharedPointer<Database> readDatabase(const QString& filename);
@@ -110,7 +111,7 @@ protected:
     QHash<QUuid, Group*> m_groups;
     QHash<QUuid, Entry*> m_entries;
 
-    QHash<QString, QByteArray> m_binaryPool;
+    QHash<QString, AttachmentPool::Handle> m_binaryPool;
     QHash<QString, QPair<Entry*, QString>> m_binaryMap;
     QByteArray m_headerHash;
 
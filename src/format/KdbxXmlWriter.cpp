@@ -47,7 +47,9 @@ void KdbxXmlWriter::writeDatabase(QIODevice* device,
     m_xml.setAutoFormattingIndent(-1); // 1 tab
     m_xml.setCodec("UTF-8");
 
-    generateIdMap();
+    if (!generateIdMap()) {
+        return;
+    }
 
     m_xml.setDevice(device);
     m_xml.writeStartDocument("1.0", true);
@@ -81,7 +83,7 @@ QString KdbxXmlWriter::errorString()
     return m_errorStr;
 }
 
-void KdbxXmlWriter::generateIdMap()
+bool KdbxXmlWriter::generateIdMap()
 {
     const QList<Entry*> allEntries = m_db->rootGroup()->entriesRecursive(true);
     int nextId = 0;
@@ -89,12 +91,26 @@ void KdbxXmlWriter::generateIdMap()
     for (Entry* entry : allEntries) {
         const QList<QString> attachmentKeys = entry->attachments()->keys();
         for (const QString& key : attachmentKeys) {
-            QByteArray data = entry->attachments()->value(key);
-            if (!m_idMap.contains(data)) {
-                m_idMap.insert(data, nextId++);
+            // attachments are keyed by their precomputed content digest
+            const QByteArray digest = entry->attachments()->digest(key);
+            if (!m_idMap.contains(digest)) {
+                m_idMap.insert(digest, nextId++);
+                if (m_kdbxVersion >= KeePass2::FILE_VERSION_4) {
+                    // KDBX 4 streams the payloads into the inner header, only the IDs are needed here
+                    continue;
+                }
+                bool ok = false;
+                const QByteArray data = entry->attachments()->value(key, &ok);
+                if (!ok) {
+                    // Never write an empty payload in place of the attachment
+                    raiseError(QObject::tr("Unable to read attachment %1 of entry %2").arg(key, entry->title()));
+                    return false;
+                }
+                m_binaries.append(data);
             }
         }
     }
+    return true;
 }
 
 void KdbxXmlWriter::writeMetadata()
@@ -183,11 +199,11 @@ void KdbxXmlWriter::writeBinaries()
 {
     m_xml.writeStartElement("Binaries");
 
-    QHash<QByteArray, int>::const_iterator i;
-    for (i = m_idMap.constBegin(); i != m_idMap.constEnd(); ++i) {
+    for (int id = 0; id < m_binaries.size(); ++id) {
+        const QByteArray& binary = m_binaries.at(id);
         m_xml.writeStartElement("Binary");
 
-        m_xml.writeAttribute("ID", QString::number(i.value()));
+        m_xml.writeAttribute("ID", QString::number(id));
 
         QByteArray data;
         if (m_db->compressionAlgorithm() == Database::CompressionGZip) {
@@ -200,15 +216,15 @@ void KdbxXmlWriter::writeBinaries()
             compressor.setStreamFormat(QtIOCompressor::GzipFormat);
             compressor.open(QIODevice::WriteOnly);
 
-            qint64 bytesWritten = compressor.write(i.key());
-            Q_ASSERT(bytesWritten == i.key().size());
+            qint64 bytesWritten = compressor.write(binary);
+            Q_ASSERT(bytesWritten == binary.size());
             Q_UNUSED(bytesWritten);
             compressor.close();
 
             buffer.seek(0);
             data = buffer.readAll();
         } else {
-            data = i.key();
+            data = binary;
         }
 
         if (!data.isEmpty()) {
@@ -402,7 +418,7 @@ void KdbxXmlWriter::writeEntry(const Entry* entry)
         writeString("Key", key);
 
         m_xml.writeStartElement("Value");
-        m_xml.writeAttribute("Ref", QString::number(m_idMap[entry->attachments()->value(key)]));
+        m_xml.writeAttribute("Ref", QString::number(m_idMap.value(entry->attachments()->digest(key))));
         m_xml.writeEndElement();
 
         m_xml.writeEndElement();
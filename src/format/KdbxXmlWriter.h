@@ -47,7 +47,7 @@ public:
     QString errorString();
 
 private:
-    void generateIdMap();
+    bool generateIdMap();
 
     void writeMetadata();
     void writeMemoryProtection();
@@ -90,6 +90,7 @@ private:
     QPointer<const Metadata> m_meta;
     KeePass2RandomStream* m_randomStream = nullptr;
     QHash<QByteArray, int> m_idMap;
+    QList<QByteArray> m_binaries;
     QByteArray m_headerHash;
 
     bool m_error = false;
@@ -543,10 +543,9 @@ void DatabaseWidget::deleteEntries(QList<Entry*> selectedEntries)
     }
 
     if (permanent) {
-        for (auto* entry : asConst(selectedEntries)) {
-            delete entry;
-        }
+        m_db->deleteItems(selectedEntries);
     } else {
+        Database::BulkUpdate bulkUpdate(m_db.data());
         for (auto* entry : asConst(selectedEntries)) {
             m_db->recycleEntry(entry);
         }
@@ -835,7 +834,7 @@ void DatabaseWidget::deleteGroup()
             MessageBox::Cancel);
 
         if (result == MessageBox::Delete) {
-            delete currentGroup;
+            m_db->deleteItems({}, {currentGroup});
         }
     } else {
         auto result = MessageBox::question(this,
@@ -240,34 +240,38 @@ QString CsvImportWidget::formatStatusText() const
 void CsvImportWidget::writeDatabase()
 {
     setRootGroup();
-    for (int r = 0; r < m_parserModel->rowCount(); ++r) {
-        // use validity of second column as a GO/NOGO for all others fields
-        if (not m_parserModel->data(m_parserModel->index(r, 1)).isValid()) {
-            continue;
-        }
-        Entry* entry = new Entry();
-        entry->setUuid(QUuid::createUuid());
-        entry->setGroup(splitGroups(m_parserModel->data(m_parserModel->index(r, 0)).toString()));
-        entry->setTitle(m_parserModel->data(m_parserModel->index(r, 1)).toString());
-        entry->setUsername(m_parserModel->data(m_parserModel->index(r, 2)).toString());
-        entry->setPassword(m_parserModel->data(m_parserModel->index(r, 3)).toString());
-        entry->setUrl(m_parserModel->data(m_parserModel->index(r, 4)).toString());
-        entry->setNotes(m_parserModel->data(m_parserModel->index(r, 5)).toString());
-
-        TimeInfo timeInfo;
-        if (m_parserModel->data(m_parserModel->index(r, 6)).isValid()) {
-            qint64 lastModified = m_parserModel->data(m_parserModel->index(r, 6)).toString().toLongLong();
-            if (lastModified) {
-                timeInfo.setLastModificationTime(Clock::datetimeUtc(lastModified * 1000));
+    {
+        // Views refresh once after all rows have been imported
+        Database::BulkUpdate bulkUpdate(m_db);
+        for (int r = 0; r < m_parserModel->rowCount(); ++r) {
+            // use validity of second column as a GO/NOGO for all others fields
+            if (not m_parserModel->data(m_parserModel->index(r, 1)).isValid()) {
+                continue;
             }
-        }
-        if (m_parserModel->data(m_parserModel->index(r, 7)).isValid()) {
-            qint64 created = m_parserModel->data(m_parserModel->index(r, 7)).toString().toLongLong();
-            if (created) {
-                timeInfo.setCreationTime(Clock::datetimeUtc(created * 1000));
+            Entry* entry = new Entry();
+            entry->setUuid(QUuid::createUuid());
+            entry->setGroup(splitGroups(m_parserModel->data(m_parserModel->index(r, 0)).toString()));
+            entry->setTitle(m_parserModel->data(m_parserModel->index(r, 1)).toString());
+            entry->setUsername(m_parserModel->data(m_parserModel->index(r, 2)).toString());
+            entry->setPassword(m_parserModel->data(m_parserModel->index(r, 3)).toString());
+            entry->setUrl(m_parserModel->data(m_parserModel->index(r, 4)).toString());
+            entry->setNotes(m_parserModel->data(m_parserModel->index(r, 5)).toString());
+
+            TimeInfo timeInfo;
+            if (m_parserModel->data(m_parserModel->index(r, 6)).isValid()) {
+                qint64 lastModified = m_parserModel->data(m_parserModel->index(r, 6)).toString().toLongLong();
+                if (lastModified) {
+                    timeInfo.setLastModificationTime(Clock::datetimeUtc(lastModified * 1000));
+                }
+            }
+            if (m_parserModel->data(m_parserModel->index(r, 7)).isValid()) {
+                qint64 created = m_parserModel->data(m_parserModel->index(r, 7)).toString().toLongLong();
+                if (created) {
+                    timeInfo.setCreationTime(Clock::datetimeUtc(created * 1000));
+                }
             }
+            entry->setTimeInfo(timeInfo);
         }
-        entry->setTimeInfo(timeInfo);
     }
     QBuffer buffer;
     buffer.open(QBuffer::ReadWrite);
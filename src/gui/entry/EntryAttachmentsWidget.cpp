@@ -243,8 +243,7 @@ void EntryAttachmentsWidget::saveSelectedAttachments() {
         }
 
         QFile file(attachmentPath);
-        const QByteArray attachmentData = m_entryAttachments->value(filename);
-        const bool saveOk = file.open(QIODevice::WriteOnly) && file.write(attachmentData) == attachmentData.size();
+        const bool saveOk = file.open(QIODevice::WriteOnly) && m_entryAttachments->writeToDevice(filename, &file);
         if (!saveOk) {
             errors.append(QString("%1 - %2").arg(filename, file.errorString()));
         }
@@ -331,7 +330,6 @@ bool EntryAttachmentsWidget::insertAttachments(const QStringList& filenames, QSt
 bool EntryAttachmentsWidget::openAttachment(const QModelIndex& index, QString& errorMessage)
 {
     const QString filename = m_attachmentsModel->keyByIndex(index);
-    const QByteArray attachmentData = m_entryAttachments->value(filename);
 
     // tmp file will be removed once the database (or the application) has been closed
 #ifdef KEEPASSXC_DIST_SNAP
@@ -345,7 +343,8 @@ bool EntryAttachmentsWidget::openAttachment(const QModelIndex& index, QString& e
 
     QScopedPointer<QTemporaryFile> tmpFile(new QTemporaryFile(tmpFileTemplate, this));
 
-    const bool saveOk = tmpFile->open() && tmpFile->write(attachmentData) == attachmentData.size() && tmpFile->flush();
+    const bool saveOk =
+        tmpFile->open() && m_entryAttachments->writeToDevice(filename, tmpFile.data()) && tmpFile->flush();
     if (!saveOk) {
         errorMessage = QString("%1 - %2").arg(filename, tmpFile->errorString());
         return false;
@@ -63,7 +63,11 @@ void EntryModel::setGroup(Group* group)
         return;
     }
 
-    beginResetModel();
+    // A bulk update already holds the model in reset
+    const bool reset = m_bulkUpdates == 0;
+    if (reset) {
+        beginResetModel();
+    }
 
     severConnections();
 
@@ -71,15 +75,22 @@ void EntryModel::setGroup(Group* group)
     m_allGroups.clear();
     m_entries = group->entries();
     m_orgEntries.clear();
+    m_bulkRemovedEntries.clear();
 
     makeConnections(group);
+    watchDatabase(group->database());
 
-    endResetModel();
+    if (reset) {
+        endResetModel();
+    }
 }
 
 void EntryModel::setEntries(const QList<Entry*>& entries)
 {
-    beginResetModel();
+    const bool reset = m_bulkUpdates == 0;
+    if (reset) {
+        beginResetModel();
+    }
 
     severConnections();
 
@@ -87,6 +98,7 @@ void EntryModel::setEntries(const QList<Entry*>& entries)
     m_allGroups.clear();
     m_entries = entries;
     m_orgEntries = entries;
+    m_bulkRemovedEntries.clear();
 
     QSet<Database*> databases;
 
@@ -110,7 +122,13 @@ void EntryModel::setEntries(const QList<Entry*>& entries)
         makeConnections(group);
     }
 
-    endResetModel();
+    for (Database* db : asConst(databases)) {
+        watchDatabase(db);
+    }
+
+    if (reset) {
+        endResetModel();
+    }
 }
 
 int EntryModel::rowCount(const QModelIndex& parent) const
@@ -179,7 +197,9 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
             }
             return result;
         case Url:
-            result = entry->resolveMultiplePlaceholders(entry->displayUrl());
+            // Plain URLs are shown as they are, only placeholders need resolving
+            result = entry->parsedUrl().hasPlaceholders ? entry->resolveMultiplePlaceholders(entry->displayUrl())
+                                                         : entry->url();
             if (attr->isReference(EntryAttributes::URLKey)) {
                 result.prepend(tr("Ref: ", "Reference abbreviation"));
             }
@@ -402,6 +422,13 @@ void EntryModel::entryAboutToAdd(Entry* entry)
         return;
     }
 
+    if (m_bulkUpdates > 0) {
+        if (!m_group && !m_bulkRemovedEntries.remove(entry) && !m_entries.contains(entry)) {
+            m_entries.append(entry);
+        }
+        return;
+    }
+
     beginInsertRows(QModelIndex(), m_entries.size(), m_entries.size());
     if (!m_group) {
         m_entries.append(entry);
@@ -410,7 +437,7 @@ void EntryModel::entryAboutToAdd(Entry* entry)
 
 void EntryModel::entryAdded(Entry* entry)
 {
-    if (!m_group && !m_orgEntries.contains(entry)) {
+    if (m_bulkUpdates > 0 || (!m_group && !m_orgEntries.contains(entry))) {
         return;
     }
 
@@ -422,6 +449,12 @@ void EntryModel::entryAdded(Entry* entry)
 
 void EntryModel::entryAboutToRemove(Entry* entry)
 {
+    if (m_bulkUpdates > 0) {
+        // The entry may be deleted before the bulk update ends
+        m_bulkRemovedEntries.insert(entry);
+        return;
+    }
+
     beginRemoveRows(QModelIndex(), m_entries.indexOf(entry), m_entries.indexOf(entry));
     if (!m_group) {
         m_entries.removeAll(entry);
@@ -430,6 +463,10 @@ void EntryModel::entryAboutToRemove(Entry* entry)
 
 void EntryModel::entryRemoved()
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     if (m_group) {
         m_entries = m_group->entries();
     }
@@ -439,6 +476,10 @@ void EntryModel::entryRemoved()
 
 void EntryModel::entryDataChanged(Entry* entry)
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     int row = m_entries.indexOf(entry);
     emit dataChanged(index(row, 0), index(row, columnCount() - 1));
 }
@@ -454,6 +495,48 @@ void EntryModel::severConnections()
     }
 }
 
+void EntryModel::bulkUpdateStarted()
+{
+    if (m_bulkUpdates++ == 0) {
+        beginResetModel();
+        m_bulkRemovedEntries.clear();
+    }
+}
+
+void EntryModel::bulkUpdateFinished()
+{
+    if (m_bulkUpdates == 0 || --m_bulkUpdates > 0) {
+        return;
+    }
+
+    if (m_group) {
+        m_entries = m_group->entries();
+    } else {
+        // Also covers the displayed group being deleted during the update
+        QList<Entry*> entries;
+        for (Entry* entry : asConst(m_entries)) {
+            if (!m_bulkRemovedEntries.contains(entry)) {
+                entries.append(entry);
+            }
+        }
+        m_entries = entries;
+    }
+    m_bulkRemovedEntries.clear();
+
+    endResetModel();
+}
+
+void EntryModel::watchDatabase(Database* db)
+{
+    if (!db || m_databases.contains(db)) {
+        return;
+    }
+
+    m_databases.append(db);
+    connect(db, SIGNAL(bulkUpdateStarted()), SLOT(bulkUpdateStarted()));
+    connect(db, SIGNAL(bulkUpdateFinished()), SLOT(bulkUpdateFinished()));
+}
+
 void EntryModel::makeConnections(const Group* group)
 {
     connect(group, SIGNAL(entryAboutToAdd(Entry*)), SLOT(entryAboutToAdd(Entry*)));
@@ -20,7 +20,10 @@
 
 #include <QAbstractTableModel>
 #include <QPixmap>
+#include <QPointer>
+#include <QSet>
 
+class Database;
 class Entry;
 class Group;
 
@@ -80,15 +83,23 @@ private slots:
     void entryAboutToRemove(Entry* entry);
     void entryRemoved();
     void entryDataChanged(Entry* entry);
+    void bulkUpdateStarted();
+    void bulkUpdateFinished();
 
 private:
     void severConnections();
     void makeConnections(const Group* group);
+    void watchDatabase(Database* db);
 
-    Group* m_group;
+    QPointer<Group> m_group;
     QList<Entry*> m_entries;
     QList<Entry*> m_orgEntries;
     QList<const Group*> m_allGroups;
+    QList<QPointer<Database>> m_databases;
+
+    // While a bulk update runs the model stays in reset and only tracks removals
+    int m_bulkUpdates = 0;
+    QSet<const Entry*> m_bulkRemovedEntries;
 
     bool m_hideUsernames;
     bool m_hidePasswords;
@@ -39,6 +39,7 @@ void GroupModel::changeDatabase(Database* newDb)
     beginResetModel();
 
     m_db = newDb;
+    m_bulkUpdates = 0;
 
     // clang-format off
     connect(m_db, SIGNAL(groupDataChanged(Group*)), SLOT(groupDataChanged(Group*)));
@@ -48,6 +49,8 @@ void GroupModel::changeDatabase(Database* newDb)
     connect(m_db, SIGNAL(groupRemoved()), SLOT(groupRemoved()));
     connect(m_db, SIGNAL(groupAboutToMove(Group*,Group*,int)), SLOT(groupAboutToMove(Group*,Group*,int)));
     connect(m_db, SIGNAL(groupMoved()), SLOT(groupMoved()));
+    connect(m_db, SIGNAL(bulkUpdateStarted()), SLOT(bulkUpdateStarted()));
+    connect(m_db, SIGNAL(bulkUpdateFinished()), SLOT(bulkUpdateFinished()));
     // clang-format on
 
     endResetModel();
@@ -353,12 +356,20 @@ QMimeData* GroupModel::mimeData(const QModelIndexList& indexes) const
 
 void GroupModel::groupDataChanged(Group* group)
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     QModelIndex ix = index(group);
     emit dataChanged(ix, ix);
 }
 
 void GroupModel::groupAboutToRemove(Group* group)
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     Q_ASSERT(group->parentGroup());
 
     QModelIndex parentIndex = parent(group);
@@ -371,11 +382,19 @@ void GroupModel::groupAboutToRemove(Group* group)
 
 void GroupModel::groupRemoved()
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     endRemoveRows();
 }
 
 void GroupModel::groupAboutToAdd(Group* group, int index)
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     Q_ASSERT(group->parentGroup());
 
     QModelIndex parentIndex = parent(group);
@@ -385,11 +404,19 @@ void GroupModel::groupAboutToAdd(Group* group, int index)
 
 void GroupModel::groupAdded()
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     endInsertRows();
 }
 
 void GroupModel::groupAboutToMove(Group* group, Group* toGroup, int pos)
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     Q_ASSERT(group->parentGroup());
 
     QModelIndex oldParentIndex = parent(group);
@@ -408,9 +435,28 @@ void GroupModel::groupAboutToMove(Group* group, Group* toGroup, int pos)
 
 void GroupModel::groupMoved()
 {
+    if (m_bulkUpdates > 0) {
+        return;
+    }
+
     endMoveRows();
 }
 
+void GroupModel::bulkUpdateStarted()
+{
+    // Structural changes are not tracked row by row until the update ends
+    if (m_bulkUpdates++ == 0) {
+        beginResetModel();
+    }
+}
+
+void GroupModel::bulkUpdateFinished()
+{
+    if (m_bulkUpdates > 0 && --m_bulkUpdates == 0) {
+        endResetModel();
+    }
+}
+
 void GroupModel::sortChildren(Group* rootGroup, bool reverse)
 {
     emit layoutAboutToBeChanged();
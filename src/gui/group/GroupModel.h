@@ -59,9 +59,12 @@ private slots:
     void groupAdded();
     void groupAboutToMove(Group* group, Group* toGroup, int pos);
     void groupMoved();
+    void bulkUpdateStarted();
+    void bulkUpdateFinished();
 
 private:
     Database* m_db;
+    int m_bulkUpdates = 0;
 };
 
 #endif // KEEPASSX_GROUPMODEL_H
@@ -39,6 +39,7 @@ GroupView::GroupView(Database* db, QWidget* parent)
     connect(this, SIGNAL(expanded(QModelIndex)), SLOT(expandedChanged(QModelIndex)));
     connect(this, SIGNAL(collapsed(QModelIndex)), SLOT(expandedChanged(QModelIndex)));
     connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), SLOT(syncExpandedState(QModelIndex,int,int)));
+    connect(m_model, SIGNAL(modelAboutToBeReset()), SLOT(modelAboutToBeReset()));
     connect(m_model, SIGNAL(modelReset()), SLOT(modelReset()));
     connect(selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)), SLOT(emitGroupChanged()));
     // clang-format on
@@ -161,8 +162,23 @@ void GroupView::setCurrentGroup(Group* group)
         setCurrentIndex(m_model->index(group));
 }
 
+void GroupView::modelAboutToBeReset()
+{
+    m_groupBeforeReset = currentGroup();
+}
+
 void GroupView::modelReset()
 {
-    recInitExpanded(m_model->groupFromIndex(m_model->index(0, 0)));
-    setCurrentIndex(m_model->index(0, 0));
+    Group* root = m_model->groupFromIndex(m_model->index(0, 0));
+    recInitExpanded(root);
+
+    // Keep the selection across bulk updates, fall back to the root group
+    // if the selected group was removed or belongs to a previous database
+    Group* group = m_groupBeforeReset;
+    m_groupBeforeReset.clear();
+    if (group && root && group->database() == root->database()) {
+        setCurrentIndex(m_model->index(group));
+    } else {
+        setCurrentIndex(m_model->index(0, 0));
+    }
 }
@@ -22,12 +22,24 @@
 #include <winsock2.h>
 #endif
 
+namespace
+{
+    const int ConnectTimeoutMs = 1000;
+} // namespace
+
 NativeMessagingHost::NativeMessagingHost()
     : NativeMessagingBase(true)
 {
     m_localSocket = new QLocalSocket();
-    m_localSocket->connectToServer(getLocalServerPath());
-    m_localSocket->setReadBufferSize(NATIVE_MSG_MAX_LENGTH);
+    // Older KeePassXC versions only listen on the legacy path and expect bare messages
+    m_localSocket->connectToServer(getFramedServerPath());
+    m_framed = m_localSocket->waitForConnected(ConnectTimeoutMs);
+    if (m_framed) {
+        m_localSocket->write(proxyProtocolMagic());
+    } else {
+        m_localSocket->connectToServer(getLocalServerPath());
+    }
+    m_localSocket->setReadBufferSize(NATIVE_MSG_MAX_LENGTH + PROXY_FRAME_HEADER_LENGTH);
 
     int socketDesc = m_localSocket->socketDescriptor();
     if (socketDesc) {
@@ -36,7 +48,8 @@ NativeMessagingHost::NativeMessagingHost()
     }
 #ifdef Q_OS_WIN
     m_running.store(1);
-    m_future = QtConcurrent::run(this, &NativeMessagingHost::readNativeMessages);
+    m_future =
+        QtConcurrent::run(this, static_cast<void (NativeMessagingHost::*)()>(&NativeMessagingHost::readNativeMessages));
 #endif
     connect(m_localSocket, SIGNAL(readyRead()), this, SLOT(newLocalMessage()));
     connect(m_localSocket, SIGNAL(disconnected()), this, SLOT(deleteSocket()));
@@ -52,67 +65,43 @@ NativeMessagingHost::~NativeMessagingHost()
 #endif
 }
 
-void NativeMessagingHost::readNativeMessages()
+void NativeMessagingHost::handleNativeMessage(const QByteArray& message)
 {
-#ifdef Q_OS_WIN
-    quint32 length = 0;
-    while (m_running.load() == 1 && !std::cin.eof()) {
-        length = 0;
-        std::cin.read(reinterpret_cast<char*>(&length), 4);
-        if (!readStdIn(length)) {
-            QCoreApplication::quit();
-        }
-        QThread::msleep(1);
+    if (m_localSocket && m_localSocket->state() == QLocalSocket::ConnectedState) {
+        m_localSocket->write(m_framed ? buildProxyFrame(++m_lastRequestId, message) : message);
+        m_localSocket->flush();
     }
-#endif
 }
 
-void NativeMessagingHost::readLength()
+void NativeMessagingHost::closeNativeInput()
 {
-    quint32 length = 0;
-    std::cin.read(reinterpret_cast<char*>(&length), 4);
-    if (!std::cin.eof() && length > 0) {
-        readStdIn(length);
-    } else {
-        QCoreApplication::quit();
-    }
+    NativeMessagingBase::closeNativeInput();
+    QCoreApplication::quit();
 }
 
-bool NativeMessagingHost::readStdIn(const quint32 length)
+void NativeMessagingHost::newLocalMessage()
 {
-    if (length <= 0) {
-        return false;
+    if (!m_localSocket || m_localSocket->bytesAvailable() <= 0) {
+        return;
     }
 
-    QByteArray arr;
-    arr.reserve(length);
-
-    for (quint32 i = 0; i < length; ++i) {
-        int c = std::getchar();
-        if (c == EOF) {
-            // message ended prematurely, ignore it and return
-            return false;
+    if (!m_framed) {
+        QByteArray arr = m_localSocket->readAll();
+        if (!arr.isEmpty()) {
+            sendReply(arr);
         }
-        arr.append(static_cast<char>(c));
-    }
-
-    if (arr.length() > 0 && m_localSocket && m_localSocket->state() == QLocalSocket::ConnectedState) {
-        m_localSocket->write(arr.constData(), arr.length());
-        m_localSocket->flush();
-    }
-
-    return true;
-}
-
-void NativeMessagingHost::newLocalMessage()
-{
-    if (!m_localSocket || m_localSocket->bytesAvailable() <= 0) {
         return;
     }
 
-    QByteArray arr = m_localSocket->readAll();
-    if (!arr.isEmpty()) {
-        sendReply(arr);
+    // Every reply is forwarded as its own native message, even when several arrive at once
+    quint32 requestId = 0;
+    QByteArray reply;
+    bool ok = true;
+    while (readProxyFrame(m_localSocket, &requestId, &reply, &ok)) {
+        sendReply(reply);
+    }
+    if (!ok) {
+        m_localSocket->disconnectFromServer();
     }
 }
 
@@ -32,13 +32,15 @@ public slots:
     void deleteSocket();
     void socketStateChanged(QLocalSocket::LocalSocketState socketState);
 
-private:
-    void readNativeMessages() override;
-    void readLength() override;
-    bool readStdIn(const quint32 length) override;
+private slots:
+    void handleNativeMessage(const QByteArray& message) override;
+    void closeNativeInput() override;
 
 private:
     QLocalSocket* m_localSocket;
+    quint32 m_lastRequestId = 0;
+    // False when connected to a KeePassXC version without framed messages
+    bool m_framed = false;
 
     Q_DISABLE_COPY(NativeMessagingHost)
 };
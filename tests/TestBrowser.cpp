@@ -17,11 +17,16 @@
 
 #include "TestBrowser.h"
 #include "TestGlobal.h"
+#include "browser/BrowserEntryConfig.h"
 #include "browser/BrowserSettings.h"
+#include "core/Metadata.h"
 #include "core/Tools.h"
 #include "crypto/Crypto.h"
+#include "gui/MessageBox.h"
 #include "sodium/crypto_box.h"
+#include <QSignalSpy>
 #include <QString>
+#include <QtConcurrent>
 
 QTEST_GUILESS_MAIN(TestBrowser)
 
@@ -84,6 +89,28 @@ void TestBrowser::testDecryptMessage()
     QCOMPARE(decrypted["action"].toString(), QString("test-action"));
 }
 
+void TestBrowser::testConcurrentDecrypt()
+{
+    QString message = "+zjtntnk4rGWSl/Ph7Vqip/swvgeupk4lNgHEm2OO3ujNr0OMz6eQtGwjtsj+/rP";
+    m_browserAction->m_publicKey = SERVERPUBLICKEY;
+    m_browserAction->m_secretKey = SERVERSECRETKEY;
+    m_browserAction->m_clientPublicKey = PUBLICKEY;
+
+    // Read-only requests of one client are decrypted on several pool threads at once
+    QList<QFuture<QJsonObject>> futures;
+    for (int i = 0; i < 16; ++i) {
+        futures << QtConcurrent::run([&] { return m_browserAction->decryptMessage(message, NONCE); });
+    }
+    for (auto& future : futures) {
+        QCOMPARE(future.result()["action"].toString(), QString("test-action"));
+    }
+
+    QVERIFY(BrowserAction::isReadOnlyAction("get-logins"));
+    QVERIFY(BrowserAction::isReadOnlyAction("test-associate"));
+    QVERIFY(!BrowserAction::isReadOnlyAction("set-login"));
+    QVERIFY(!BrowserAction::isReadOnlyAction("associate"));
+}
+
 void TestBrowser::testGetBase64FromKey()
 {
     unsigned char pk[crypto_box_PUBLICKEYBYTES];
@@ -251,6 +278,72 @@ void TestBrowser::testSearchEntriesWithAdditionalURLs()
     QCOMPARE(additionalResult[0]->url(), QString("https://github.com/"));
 }
 
+void TestBrowser::testSearchEntriesAfterChanges()
+{
+    auto db = QSharedPointer<Database>::create();
+    auto* root = db->rootGroup();
+    auto* group = new Group();
+    group->setParent(root);
+
+    QStringList urls = {"https://github.com/", "https://www.example.com"};
+    auto entries = createEntries(urls, group);
+
+    auto result = m_browserService->searchEntries(db, "https://github.com", "https://github.com/session");
+    QCOMPARE(result, QList<Entry*>({entries[0]}));
+
+    // Changed, added and moved entries are found without a rescan, in tree order
+    entries[1]->setUrl("https://github.com/login");
+    entries[1]->attributes()->set(BrowserService::ADDITIONAL_URL, "https://keepassxc.org");
+    QStringList rootUrls = {"github.com"};
+    auto rootEntries = createEntries(rootUrls, root);
+    result = m_browserService->searchEntries(db, "https://github.com", "https://github.com/session");
+    QCOMPARE(result, QList<Entry*>({rootEntries[0], entries[0], entries[1]}));
+    result = m_browserService->searchEntries(db, "https://keepassxc.org", "https://keepassxc.org");
+    QCOMPARE(result, QList<Entry*>({entries[1]}));
+
+    entries[0]->setUrl("https://example.com");
+    rootEntries[0]->setGroup(group);
+    result = m_browserService->searchEntries(db, "https://github.com", "https://github.com/session");
+    QCOMPARE(result, QList<Entry*>({entries[1], rootEntries[0]}));
+
+    // Removed and recycled entries are gone
+    delete rootEntries[0];
+    db->metadata()->setRecycleBinEnabled(true);
+    db->recycleEntry(entries[1]);
+    result = m_browserService->searchEntries(db, "https://github.com", "https://github.com/session");
+    QVERIFY(result.isEmpty());
+    result = m_browserService->searchEntries(db, "https://example.com", "https://example.com");
+    QCOMPARE(result, QList<Entry*>({entries[0]}));
+}
+
+void TestBrowser::testSearchEntriesForSites()
+{
+    auto db = QSharedPointer<Database>::create();
+    auto* root = db->rootGroup();
+
+    QStringList urls = {"https://github.com/login", "https://accounts.example.com", "https://example.com/"};
+    createEntries(urls, root);
+
+    StringPairList sites = {qMakePair(QString("https://github.com/session"), QString("https://github.com/session")),
+                            qMakePair(QString("https://example.com"), QString("https://example.com/login")),
+                            qMakePair(QString(), QString()),
+                            qMakePair(QString("https://github.com/session"), QString("https://github.com/session")),
+                            qMakePair(QString("https://keepassxc.org"), QString())};
+
+    auto results = m_browserService->searchEntries(db, sites);
+    QCOMPARE(results.size(), sites.size());
+    for (int i = 0; i < sites.size(); ++i) {
+        if (sites[i].first.isEmpty()) {
+            QVERIFY(results[i].isEmpty());
+        } else {
+            QCOMPARE(results[i], m_browserService->searchEntries(db, sites[i].first, sites[i].second));
+        }
+    }
+    QCOMPARE(results[0].size(), 1);
+    QCOMPARE(results[3], results[0]);
+    QVERIFY(results[4].isEmpty());
+}
+
 void TestBrowser::testInvalidEntries()
 {
     auto db = QSharedPointer<Database>::create();
@@ -393,6 +486,67 @@ void TestBrowser::testSortEntries()
     QCOMPARE(result[3]->url(), QString("github.com/login"));
 }
 
+void TestBrowser::testCheckAccess()
+{
+    QScopedPointer<Entry> entry(new Entry());
+    QCOMPARE(m_browserService->checkAccess(entry.data(), "example.com", "", ""), BrowserService::Unknown);
+
+    BrowserEntryConfig config;
+    config.allow("example.com");
+    config.deny("evil.example.com");
+    config.setRealm("Example");
+    config.save(entry.data());
+
+    QCOMPARE(m_browserService->checkAccess(entry.data(), "example.com", "", ""), BrowserService::Allowed);
+    QCOMPARE(m_browserService->checkAccess(entry.data(), "example.com", "example.com", ""), BrowserService::Allowed);
+    QCOMPARE(m_browserService->checkAccess(entry.data(), "evil.example.com", "", ""), BrowserService::Denied);
+    QCOMPARE(m_browserService->checkAccess(entry.data(), "other.com", "", "Other"), BrowserService::Denied);
+    QCOMPARE(m_browserService->checkAccess(entry.data(), "other.com", "", "Example"), BrowserService::Unknown);
+
+    // The decoded rules follow changes of the settings
+    config.allow("evil.example.com");
+    config.save(entry.data());
+    QCOMPARE(m_browserService->checkAccess(entry.data(), "evil.example.com", "", ""), BrowserService::Allowed);
+
+    entry->customData()->remove(BrowserService::KEEPASSXCBROWSER_NAME);
+    QCOMPARE(m_browserService->checkAccess(entry.data(), "evil.example.com", "", ""), BrowserService::Unknown);
+    QVERIFY(!BrowserEntryConfig::accessRules(entry.data()).loaded);
+}
+
+void TestBrowser::testConvertAttributesToCustomData()
+{
+    auto db = QSharedPointer<Database>::create();
+    auto* root = db->rootGroup();
+
+    QStringList urls = {"https://example.com", "https://example.org"};
+    auto entries = createEntries(urls, root);
+    entries[0]->attributes()->set("KeePassHttp Settings", "{\"Allow\":[\"example.net\"]}");
+    entries[0]->attributes()->set(BrowserService::KEEPASSXCBROWSER_NAME, "{\"Allow\":[\"example.com\"]}");
+
+    auto* keyEntry = new Entry();
+    keyEntry->setUuid(QUuid::createUuid());
+    keyEntry->setTitle("KeePassHttp Settings");
+    keyEntry->attributes()->set(BrowserService::LEGACY_ASSOCIATE_KEY_PREFIX + "legacy", "key");
+    keyEntry->setGroup(root);
+
+    // All legacy attributes of an entry are converted in one update
+    const int historySize = entries[0]->historyItems().size();
+    QSignalSpy bulkUpdates(db.data(), SIGNAL(bulkUpdateFinished()));
+    MessageBox::setNextAnswer(MessageBox::Ok);
+    m_browserService->convertAttributesToCustomData(db);
+
+    QCOMPARE(bulkUpdates.count(), 1);
+    QVERIFY(!entries[0]->attributes()->contains("KeePassHttp Settings"));
+    QVERIFY(!entries[0]->attributes()->contains(BrowserService::KEEPASSXCBROWSER_NAME));
+    QCOMPARE(entries[0]->customData()->value(BrowserService::KEEPASSXCBROWSER_NAME),
+             QString("{\"Allow\":[\"example.com\"]}"));
+    QCOMPARE(entries[0]->historyItems().size(), historySize + 1);
+    QVERIFY(entries[1]->customData()->isEmpty());
+
+    QCOMPARE(root->entries().size(), 2);
+    QCOMPARE(db->metadata()->customData()->value(BrowserService::ASSOCIATE_KEY_PREFIX + "legacy"), QString("key"));
+}
+
 void TestBrowser::testGetDatabaseGroups()
 {
     auto db = QSharedPointer<Database>::create();
@@ -35,6 +35,7 @@ private slots:
     void testChangePublicKeys();
     void testEncryptMessage();
     void testDecryptMessage();
+    void testConcurrentDecrypt();
     void testGetBase64FromKey();
     void testIncrementNonce();
 
@@ -43,9 +44,13 @@ private slots:
     void testSearchEntries();
     void testSearchEntriesWithPort();
     void testSearchEntriesWithAdditionalURLs();
+    void testSearchEntriesAfterChanges();
+    void testSearchEntriesForSites();
     void testInvalidEntries();
     void testSubdomainsAndPaths();
     void testSortEntries();
+    void testCheckAccess();
+    void testConvertAttributesToCustomData();
     void testGetDatabaseGroups();
     void testValidURLs();
 
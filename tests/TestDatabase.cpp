@@ -206,3 +206,107 @@ void TestDatabase::testEmptyRecycleBinWithHierarchicalData()
     writer.writeDatabase(&afterCleanup, db.data());
     QVERIFY(afterCleanup.size() < initialSize);
 }
+
+void TestDatabase::testCommonUsernames()
+{
+    Database db;
+    auto group = new Group();
+    group->setParent(db.rootGroup());
+
+    auto entry1 = new Entry();
+    entry1->setUsername("alice");
+    entry1->setGroup(db.rootGroup());
+    auto entry2 = new Entry();
+    entry2->setUsername("bob");
+    entry2->setGroup(group);
+    auto entry3 = new Entry();
+    entry3->setUsername("bob");
+    entry3->setGroup(group);
+    auto entry4 = new Entry();
+    entry4->setGroup(db.rootGroup());
+    entry4->setUsername(QString("{REF:U@I:%1}").arg(entry1->uuidToHex()));
+
+    QCOMPARE(db.commonUsernames(), QList<QString>({"bob", "alice"}));
+    QCOMPARE(db.commonUsernames(), db.rootGroup()->usernamesRecursive(10));
+    QCOMPARE(db.commonUsernames(1), QList<QString>({"bob"}));
+
+    // Changes are reflected without a rescan
+    entry1->setUsername("carol");
+    entry3->setUsername("carol");
+    QCOMPARE(db.commonUsernames(), QList<QString>({"carol", "bob"}));
+
+    delete entry2;
+    QCOMPARE(db.commonUsernames(), QList<QString>({"carol"}));
+
+    // Moving a group to another database moves its usernames along
+    Database other;
+    auto entry5 = new Entry();
+    entry5->setUsername("dave");
+    entry5->setGroup(group);
+    group->setParent(other.rootGroup());
+    QCOMPARE(db.commonUsernames(), QList<QString>({"carol"}));
+    QCOMPARE(other.commonUsernames(), QList<QString>({"carol", "dave"}));
+
+    entry4->setUsername("erin");
+    QCOMPARE(db.commonUsernames(), QList<QString>({"carol", "erin"}));
+}
+
+void TestDatabase::testDeleteItems()
+{
+    Database db;
+    auto group = new Group();
+    group->setParent(db.rootGroup());
+    auto subgroup = new Group();
+    subgroup->setParent(group);
+    auto keptGroup = new Group();
+    keptGroup->setParent(db.rootGroup());
+
+    QList<Entry*> entries;
+    for (Group* parent : {group, subgroup, db.rootGroup(), db.rootGroup()}) {
+        auto entry = new Entry();
+        entry->setUsername("user");
+        entry->setGroup(parent);
+        entries.append(entry);
+    }
+    auto keptEntry = new Entry();
+    keptEntry->setUsername("kept");
+    keptEntry->setGroup(keptGroup);
+
+    const QUuid groupUuid = group->uuid();
+    const QUuid subgroupUuid = subgroup->uuid();
+    const int deletedObjects = db.deletedObjects().size();
+
+    QSignalSpy spyStarted(&db, SIGNAL(bulkUpdateStarted()));
+    QSignalSpy spyFinished(&db, SIGNAL(bulkUpdateFinished()));
+    QSignalSpy spyGroupRemoved(&db, SIGNAL(groupRemoved()));
+
+    // Entries below a deleted group may be passed as well
+    db.deleteItems({entries[1], entries[2], entries[3]}, {group, subgroup});
+
+    QCOMPARE(spyStarted.count(), 1);
+    QCOMPARE(spyFinished.count(), 1);
+    // Only the top of the deleted subtree is removed from the database one by one
+    QCOMPARE(spyGroupRemoved.count(), 1);
+
+    QCOMPARE(db.rootGroup()->children(), QList<Group*>({keptGroup}));
+    QVERIFY(db.rootGroup()->entries().isEmpty());
+    QCOMPARE(db.rootGroup()->entriesRecursive(), QList<Entry*>({keptEntry}));
+    QCOMPARE(db.commonUsernames(), QList<QString>({"kept"}));
+
+    QCOMPARE(db.deletedObjects().size(), deletedObjects + 6);
+    QVERIFY(db.containsDeletedObject(groupUuid));
+    QVERIFY(db.containsDeletedObject(subgroupUuid));
+    QVERIFY(!db.containsDeletedObject(keptEntry->uuid()));
+    QVERIFY(db.isModified());
+
+    // Emptying the recycle bin goes through the same path
+    db.metadata()->setRecycleBinEnabled(true);
+    db.recycleEntry(keptEntry);
+    db.recycleGroup(keptGroup);
+    QVERIFY(db.metadata()->recycleBin());
+    db.emptyRecycleBin();
+    QVERIFY(db.metadata()->recycleBin()->entries().isEmpty());
+    QVERIFY(db.metadata()->recycleBin()->children().isEmpty());
+    QCOMPARE(db.deletedObjects().size(), deletedObjects + 8);
+    QCOMPARE(spyStarted.count(), 2);
+}
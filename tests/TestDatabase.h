@@ -34,6 +34,8 @@ private slots:
     void testEmptyRecycleBinOnNotCreated();
     void testEmptyRecycleBinOnEmpty();
     void testEmptyRecycleBinWithHierarchicalData();
+    void testCommonUsernames();
+    void testDeleteItems();
 };
 
 #endif // KEEPASSX_TESTDATABASE_H
@@ -19,6 +19,7 @@
 #include "TestGlobal.h"
 
 #include "config-keepassx-tests.h"
+#include "core/Metadata.h"
 #include "crypto/Crypto.h"
 #include "format/KdbxXmlReader.h"
 #include "format/KeePass2.h"
@@ -151,3 +152,39 @@ void TestDeletedObjects::testDatabaseChange()
 
     delete group;
 }
+
+void TestDeletedObjects::testCompactDeletedObjects()
+{
+    Database db;
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    DeletedObject oldObject{QUuid::createUuid(), now.addDays(-400)};
+    DeletedObject recentObject{QUuid::createUuid(), now.addDays(-10)};
+    DeletedObject newObject{QUuid::createUuid(), now};
+    db.addDeletedObject(recentObject);
+    db.addDeletedObject(oldObject);
+    db.addDeletedObject(newObject);
+    QVERIFY(db.containsDeletedObject(oldObject.uuid));
+    QVERIFY(db.containsDeletedObject(recentObject));
+
+    QCOMPARE(db.compactDeletedObjects(now.addDays(-365)), 1);
+    QCOMPARE(db.deletedObjects().size(), 2);
+    QCOMPARE(db.deletedObjects().at(0).uuid, recentObject.uuid);
+    QCOMPARE(db.deletedObjects().at(1).uuid, newObject.uuid);
+    QVERIFY(!db.containsDeletedObject(oldObject.uuid));
+    QVERIFY(db.containsDeletedObject(recentObject.uuid));
+    QCOMPARE(db.compactDeletedObjects(now.addDays(-365)), 0);
+
+    db.setDeletedObjects({oldObject});
+    QVERIFY(db.containsDeletedObject(oldObject.uuid));
+    QVERIFY(!db.containsDeletedObject(newObject.uuid));
+
+    // Deleted objects are kept forever unless the database asks otherwise
+    QCOMPARE(db.deletedObjectsRetention(), 0);
+    db.setDeletedObjectsRetention(365);
+    QCOMPARE(db.deletedObjectsRetention(), 365);
+    QCOMPARE(db.metadata()->customData()->value("KPXC_DELETED_OBJECTS_RETENTION_DAYS"), QString("365"));
+    db.setDeletedObjectsRetention(0);
+    QCOMPARE(db.deletedObjectsRetention(), 0);
+    QVERIFY(!db.metadata()->customData()->contains("KPXC_DELETED_OBJECTS_RETENTION_DAYS"));
+}
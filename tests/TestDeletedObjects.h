@@ -34,6 +34,7 @@ private slots:
     void testDeletedObjectsFromFile();
     void testDeletedObjectsFromNewDb();
     void testDatabaseChange();
+    void testCompactDeletedObjects();
 };
 
 #endif // KEEPASSX_TESTDELETEDOBJECTS_H
@@ -16,19 +16,29 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QBuffer>
 #include <QScopedPointer>
 
 #include "TestEntry.h"
 #include "TestGlobal.h"
+#include "core/AttachmentPool.h"
 #include "core/Clock.h"
 #include "core/Metadata.h"
 #include "crypto/Crypto.h"
+#include "crypto/Random.h"
 
 QTEST_GUILESS_MAIN(TestEntry)
 
 void TestEntry::initTestCase()
 {
     QVERIFY(Crypto::init());
+    m_spillThreshold = AttachmentPool::instance()->spillThreshold();
+}
+
+void TestEntry::cleanup()
+{
+    // Tests that change the threshold may fail before restoring it
+    AttachmentPool::instance()->setSpillThreshold(m_spillThreshold);
 }
 
 void TestEntry::testHistoryItemDeletion()
@@ -81,6 +91,285 @@ void TestEntry::testCopyDataFrom()
     QCOMPARE(entry2->autoTypeAssociations()->get(1).window, QString("3"));
 }
 
+void TestEntry::testAttributes()
+{
+    EntryAttributes attributes;
+    QCOMPARE(attributes.keys(), QList<QString>({"Notes", "Password", "Title", "URL", "UserName"}));
+    QVERIFY(attributes.customKeys().isEmpty());
+
+    attributes.set("b", "2");
+    attributes.set("Aa", "1", true);
+    attributes.set("Z", "3");
+    attributes.set(EntryAttributes::PasswordKey, "secret", true);
+
+    // keys are listed in the same order as before the compact storage
+    QCOMPARE(attributes.keys(),
+             QList<QString>({"Aa", "Notes", "Password", "Title", "URL", "UserName", "Z", "b"}));
+    QCOMPARE(attributes.customKeys(), QList<QString>({"Aa", "Z", "b"}));
+    QCOMPARE(attributes.value("Aa"), QString("1"));
+    QCOMPARE(attributes.value(EntryAttributes::PasswordKey), QString("secret"));
+    QVERIFY(attributes.value("missing").isNull());
+    QVERIFY(attributes.isProtected("Aa"));
+    QVERIFY(attributes.isProtected(EntryAttributes::PasswordKey));
+    QVERIFY(!attributes.isProtected("b"));
+    QVERIFY(!attributes.isProtected(EntryAttributes::TitleKey));
+    QVERIFY(attributes.containsValue("3"));
+    QVERIFY(!attributes.contains("missing"));
+
+    attributes.rename("Aa", "c");
+    QCOMPARE(attributes.customKeys(), QList<QString>({"Z", "b", "c"}));
+    QVERIFY(attributes.isProtected("c"));
+    attributes.remove("Z");
+    QCOMPARE(attributes.customKeys(), QList<QString>({"b", "c"}));
+
+    EntryAttributes other;
+    other.set("c", "1", true);
+    other.set("b", "2");
+    other.set(EntryAttributes::PasswordKey, "secret", true);
+    QVERIFY(!attributes.areCustomKeysDifferent(&other));
+    QVERIFY(attributes == other);
+
+    // Custom keys are shared between all attribute sets
+    QString key = QString("Shared") + QString("Key");
+    attributes.set(key, "x");
+    other.set("SharedKey", "y");
+    QVERIFY(attributes.customKeys().first().constData() == other.customKeys().first().constData());
+    QVERIFY(attributes != other);
+
+    other.copyDataFrom(&attributes);
+    QVERIFY(attributes == other);
+    QCOMPARE(other.value("SharedKey"), QString("x"));
+}
+
+void TestEntry::testReleaseUnusedKeys()
+{
+    EntryAttributes::releaseUnusedKeys();
+
+    QScopedPointer<Entry> entry(new Entry());
+    QScopedPointer<Entry> other(new Entry());
+    entry->attributes()->set(QString("Secret key %1").arg(1), "value");
+    other->attributes()->set(QString("Secret key %1").arg(1), "other value");
+
+    // Keys stay interned while any entry uses them
+    entry.reset();
+    QCOMPARE(EntryAttributes::releaseUnusedKeys(), 0);
+    other.reset();
+    QCOMPARE(EntryAttributes::releaseUnusedKeys(), 1);
+}
+
+void TestEntry::testHistoryStorage()
+{
+    Database db;
+    db.metadata()->setHistoryMaxItems(-1);
+    db.metadata()->setHistoryMaxSize(-1);
+
+    auto entry = new Entry();
+    entry->setGroup(db.rootGroup());
+    entry->setNotes(QString("notes").repeated(100));
+    entry->attributes()->set("custom", QString("value").repeated(100));
+
+    // Loaded history items carry their own copies of unchanged values
+    for (int i = 0; i < 3; ++i) {
+        auto item = new Entry();
+        item->setTitle(QString::number(i));
+        item->setNotes(QString("notes").repeated(100));
+        item->attributes()->set("custom", QString("value").repeated(100));
+        entry->addHistoryItem(item);
+    }
+
+    const auto history = entry->historyItems();
+    for (const Entry* item : history) {
+        QCOMPARE(item->notes().constData(), entry->notes().constData());
+        QCOMPARE(item->attributes()->value("custom").constData(), entry->attributes()->value("custom").constData());
+    }
+    QVERIFY(history[0]->title().constData() != history[1]->title().constData());
+
+    int size = 0;
+    for (const Entry* item : history) {
+        size += item->attributes()->attributesSize();
+    }
+    QCOMPARE(entry->historySize(), size);
+
+    // Editing a history item in place is picked up
+    history[0]->setNotes("");
+    QCOMPARE(entry->historySize(), size - QString("notes").repeated(100).size());
+
+    entry->removeHistoryItems({history[1]});
+    QCOMPARE(entry->historySize(),
+             history[0]->attributes()->attributesSize() + history[2]->attributes()->attributesSize());
+
+    db.metadata()->setHistoryMaxItems(1);
+    entry->truncateHistory();
+    QCOMPARE(entry->historyItems().size(), 1);
+    QCOMPARE(entry->historySize(), history[2]->attributes()->attributesSize());
+}
+
+void TestEntry::testDigest()
+{
+    QScopedPointer<Entry> entry(new Entry());
+    entry->setUuid(QUuid::createUuid());
+    entry->setTitle("title");
+    entry->attachments()->set("file", "content");
+    QScopedPointer<Entry> clone(entry->clone(Entry::CloneNoFlags));
+    clone->setUpdateTimeinfo(false);
+
+    QCOMPARE(entry->digest(), clone->digest());
+    QVERIFY(entry->equals(clone.data()));
+
+    // Every kind of change invalidates the cached digest
+    const QByteArray digest = entry->digest();
+    clone->setTitle("changed");
+    QVERIFY(clone->digest() != digest);
+    QVERIFY(!entry->equals(clone.data()));
+    clone->setTitle("title");
+    QCOMPARE(clone->digest(), digest);
+
+    clone->attachments()->set("file", "other content");
+    QVERIFY(!entry->equals(clone.data()));
+    clone->attachments()->set("file", "content");
+    QVERIFY(entry->equals(clone.data()));
+
+    TimeInfo timeInfo = clone->timeInfo();
+    timeInfo.setLastModificationTime(timeInfo.lastModificationTime().addMSecs(1));
+    clone->setTimeInfo(timeInfo);
+    QVERIFY(clone->digest() != digest);
+    QVERIFY(!entry->equals(clone.data()));
+    // Relaxed comparisons fall back to comparing the fields
+    QVERIFY(entry->equals(clone.data(), CompareItemIgnoreMilliseconds));
+
+    clone->copyDataFrom(entry.data());
+    QCOMPARE(clone->digest(), digest);
+
+    // The same point in time in another time spec is still equal
+    timeInfo = entry->timeInfo();
+    timeInfo.setCreationTime(timeInfo.creationTime().toOffsetFromUtc(3600));
+    clone->setTimeInfo(timeInfo);
+    QCOMPARE(clone->digest(), digest);
+
+    // History is compared separately from the digest
+    clone->addHistoryItem(entry->clone(Entry::CloneNoFlags));
+    QCOMPARE(clone->digest(), digest);
+    QVERIFY(!entry->equals(clone.data()));
+    QVERIFY(entry->equals(clone.data(), CompareItemIgnoreHistory));
+
+    // Null and empty values are equal, although their digests differ
+    entry->setUpdateTimeinfo(false);
+    entry->attributes()->set("custom", QString());
+    clone->attributes()->set("custom", QString(""));
+    QVERIFY(entry->digest() != clone->digest());
+    QVERIFY(entry->equals(clone.data(), CompareItemIgnoreHistory));
+}
+
+void TestEntry::testCloneSharesData()
+{
+    QScopedPointer<Entry> entry(new Entry());
+    entry->setUpdateTimeinfo(false);
+    entry->setNotes(QString(4096, 'n'));
+    entry->attributes()->set("custom", "value", true);
+    entry->attachments()->set("file", QByteArray(1024, 'a'));
+    const QByteArray digest = entry->digest();
+
+    QScopedPointer<Entry> clone(entry->clone(Entry::CloneNoFlags));
+    clone->setUpdateTimeinfo(false);
+
+    // The clone references the same attribute storage until it is written to
+    QCOMPARE(clone->notes().constData(), entry->notes().constData());
+    QVERIFY(*clone->attributes() == *entry->attributes());
+    QCOMPARE(clone->digest(), digest);
+
+    // Setting an unchanged value must not break up the sharing
+    clone->setNotes(entry->notes());
+    clone->attributes()->set("custom", "value", true);
+    QCOMPARE(clone->notes().constData(), entry->notes().constData());
+
+    clone->attributes()->set("custom", "changed", true);
+    QCOMPARE(entry->attributes()->value("custom"), QString("value"));
+    QCOMPARE(clone->attributes()->value("custom"), QString("changed"));
+    QCOMPARE(clone->notes(), entry->notes());
+    QVERIFY(clone->digest() != digest);
+    QCOMPARE(entry->digest(), digest);
+}
+
+void TestEntry::testParsedUrl()
+{
+    QScopedPointer<Entry> entry(new Entry());
+    entry->setUrl("https://accounts.example.co.uk:8443/login/");
+
+    EntryUrl url = entry->parsedUrl();
+    QVERIFY(url.hasScheme);
+    QCOMPARE(url.host, QString("accounts.example.co.uk"));
+    QCOMPARE(url.baseDomain, QString("example.co.uk"));
+    QCOMPARE(url.port, 8443);
+    QCOMPARE(url.path, QString("/login/"));
+    QCOMPARE(url.normalized, QString("https://accounts.example.co.uk:8443/login"));
+    QCOMPARE(url.normalizedBase, QString("https://accounts.example.co.uk:8443"));
+    QVERIFY(!url.hasPlaceholders);
+
+    // URLs without a scheme are matched like user input
+    entry->setUrl("example.com");
+    url = entry->parsedUrl();
+    QVERIFY(!url.hasScheme);
+    QCOMPARE(url.host, QString("example.com"));
+    QCOMPARE(url.baseDomain, QString("example.com"));
+    QCOMPARE(url.port, -1);
+
+    // Additional URLs are parsed on their own and follow attribute changes
+    entry->attributes()->set("KP2A_URL", "{S:Site}");
+    QVERIFY(entry->parsedUrl("KP2A_URL").hasPlaceholders);
+    QVERIFY(entry->parsedUrl("KP2A_URL").host.isEmpty());
+    entry->attributes()->set("KP2A_URL", "http://192.168.0.1");
+    QCOMPARE(entry->parsedUrl("KP2A_URL").host, QString("192.168.0.1"));
+    QCOMPARE(entry->parsedUrl("KP2A_URL").baseDomain, QString("192.168.0.1"));
+    QCOMPARE(entry->parsedUrl().host, QString("example.com"));
+}
+
+void TestEntry::testAttachmentDeduplication()
+{
+    const QByteArray payload(1024, 'x');
+    const int poolCount = AttachmentPool::instance()->count();
+
+    QScopedPointer<Entry> entry1(new Entry());
+    QScopedPointer<Entry> entry2(new Entry());
+    entry1->attachments()->set("a", payload);
+    entry2->attachments()->set("b", QByteArray(1024, 'x'));
+
+    // identical payloads share a single pooled buffer
+    QCOMPARE(AttachmentPool::instance()->count(), poolCount + 1);
+    QCOMPARE(entry1->attachments()->digest("a"), entry2->attachments()->digest("b"));
+    QCOMPARE(entry1->attachments()->value("a").constData(), entry2->attachments()->value("b").constData());
+
+    entry2->attachments()->set("b", "changed");
+    QVERIFY(entry1->attachments()->digest("a") != entry2->attachments()->digest("b"));
+    QCOMPARE(entry1->attachments()->value("a"), payload);
+
+    // the payload is dropped once no entry references it anymore
+    entry1.reset();
+    entry2.reset();
+    QCOMPARE(AttachmentPool::instance()->count(), poolCount);
+}
+
+void TestEntry::testLargeAttachmentSpill()
+{
+    AttachmentPool::instance()->setSpillThreshold(4096);
+
+    QByteArray payload = randomGen()->randomArray(3 * 1024 * 1024 + 7);
+    QScopedPointer<Entry> entry(new Entry());
+    entry->attachments()->set("large", payload);
+    entry->attachments()->set("small", "123");
+
+    // The pool hands out the blobs the entry holds
+    QVERIFY(AttachmentPool::instance()->intern(payload)->isSpilled());
+    QVERIFY(!AttachmentPool::instance()->intern("123")->isSpilled());
+    QCOMPARE(entry->attachments()->size("large"), payload.size());
+    QCOMPARE(entry->attachments()->value("large"), payload);
+    QCOMPARE(entry->attachments()->value("small"), QByteArray("123"));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(entry->attachments()->writeToDevice("large", &buffer));
+    QCOMPARE(buffer.data(), payload);
+}
+
 void TestEntry::testClone()
 {
     QScopedPointer<Entry> entryOrg(new Entry());
@@ -441,6 +730,45 @@ void TestEntry::testResolveReferencePlaceholders()
              entry3->attributes()->value("AttributeNotes"));
 }
 
+void TestEntry::testResolveReferenceCache()
+{
+    Database db;
+    auto* root = db.rootGroup();
+
+    auto* entry1 = new Entry();
+    entry1->setGroup(root);
+    entry1->setUuid(QUuid::createUuid());
+    entry1->setTitle("Title1");
+    entry1->setUsername("Username1");
+
+    auto* tstEntry = new Entry();
+    tstEntry->setGroup(root);
+    tstEntry->setUuid(QUuid::createUuid());
+
+    const QString byTitle("{REF:U@T:Title1}");
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(byTitle), QString("Username1"));
+
+    // Changes to the referenced entry are picked up
+    entry1->setUsername("Username2");
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(byTitle), QString("Username2"));
+
+    entry1->setTitle("Title2");
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(byTitle), QString());
+
+    // So are entries added and removed after a failed lookup
+    auto* entry2 = new Entry();
+    entry2->setGroup(root);
+    entry2->setUuid(QUuid::createUuid());
+    entry2->setTitle("Title1");
+    entry2->setUsername("Username3");
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(byTitle), QString("Username3"));
+    QCOMPARE(db.findEntryByReference("Title1", EntryReferenceType::Title), entry2);
+
+    delete entry2;
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(byTitle), QString());
+    QVERIFY(!db.findEntryByReference("Title1", EntryReferenceType::Title));
+}
+
 void TestEntry::testResolveNonIdPlaceholdersToUuid()
 {
     Database db;
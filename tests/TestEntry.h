@@ -28,16 +28,29 @@ class TestEntry : public QObject
 
 private slots:
     void initTestCase();
+    void cleanup();
     void testHistoryItemDeletion();
     void testCopyDataFrom();
+    void testAttributes();
+    void testReleaseUnusedKeys();
+    void testHistoryStorage();
+    void testDigest();
+    void testCloneSharesData();
+    void testParsedUrl();
+    void testAttachmentDeduplication();
+    void testLargeAttachmentSpill();
     void testClone();
     void testResolveUrl();
     void testResolveUrlPlaceholders();
     void testResolveRecursivePlaceholders();
     void testResolveReferencePlaceholders();
+    void testResolveReferenceCache();
     void testResolveNonIdPlaceholdersToUuid();
     void testResolveClonedEntry();
     void testIsRecycled();
+
+private:
+    int m_spillThreshold = 0;
 };
 
 #endif // KEEPASSX_TESTENTRY_H
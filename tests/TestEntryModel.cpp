@@ -360,3 +360,59 @@ void TestEntryModel::testDatabaseDelete()
     delete modelTest;
     delete model;
 }
+
+void TestEntryModel::testBulkUpdate()
+{
+    EntryModel* model = new EntryModel(this);
+    ModelTest* modelTest = new ModelTest(model, this);
+
+    Database* db = new Database();
+    Entry* entry1 = new Entry();
+    entry1->setGroup(db->rootGroup());
+    model->setGroup(db->rootGroup());
+
+    QSignalSpy spyStarted(db, SIGNAL(bulkUpdateStarted()));
+    QSignalSpy spyFinished(db, SIGNAL(bulkUpdateFinished()));
+    QSignalSpy spyReset(model, SIGNAL(modelReset()));
+    QSignalSpy spyAdded(model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+    QSignalSpy spyRemoved(model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+
+    {
+        Database::BulkUpdate bulkUpdate(db);
+        QVERIFY(db->isBulkUpdating());
+        for (int i = 0; i < 10; ++i) {
+            auto entry = new Entry();
+            entry->setGroup(db->rootGroup());
+        }
+        {
+            // Nested updates are folded into the outer one
+            Database::BulkUpdate nested(db);
+            delete entry1;
+        }
+        QCOMPARE(spyFinished.count(), 0);
+    }
+
+    QVERIFY(!db->isBulkUpdating());
+    QCOMPARE(spyStarted.count(), 1);
+    QCOMPARE(spyFinished.count(), 1);
+    QCOMPARE(spyReset.count(), 1);
+    QCOMPARE(spyAdded.count(), 0);
+    QCOMPARE(spyRemoved.count(), 0);
+    QCOMPARE(model->rowCount(), 10);
+
+    // Search results drop entries deleted during the update
+    QList<Entry*> entries = db->rootGroup()->entries();
+    model->setEntries(entries);
+    spyReset.clear();
+    {
+        Database::BulkUpdate bulkUpdate(db);
+        delete entries.takeFirst();
+        delete entries.takeFirst();
+    }
+    QCOMPARE(spyReset.count(), 1);
+    QCOMPARE(model->rowCount(), 8);
+
+    delete modelTest;
+    delete model;
+    delete db;
+}
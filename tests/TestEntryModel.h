@@ -34,6 +34,7 @@ private slots:
     void testAutoTypeAssociationsModel();
     void testProxyModel();
     void testDatabaseDelete();
+    void testBulkUpdate();
 };
 
 #endif // KEEPASSX_TESTENTRYMODEL_H
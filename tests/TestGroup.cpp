@@ -616,6 +616,52 @@ void TestGroup::testFindGroupByPath()
     QVERIFY(!group);
 }
 
+void TestGroup::testFindByPathAfterChanges()
+{
+    Database db;
+
+    auto group1 = new Group();
+    group1->setName("group1");
+    group1->setParent(db.rootGroup());
+    auto group2 = new Group();
+    group2->setName("group2");
+    group2->setParent(db.rootGroup());
+
+    auto entry1 = new Entry();
+    entry1->setTitle("entry");
+    entry1->setGroup(group1);
+    auto entry2 = new Entry();
+    entry2->setTitle("entry");
+    entry2->setGroup(group2);
+
+    // Duplicate titles resolve to the first match in tree order
+    QCOMPARE(db.rootGroup()->findEntryByPath("entry"), entry1);
+    QCOMPARE(db.rootGroup()->findEntryByPath("/group2/entry"), entry2);
+    QCOMPARE(db.rootGroup()->locate("entry"), QStringList({"/group1/entry", "/group2/entry"}));
+
+    group1->setName("renamed");
+    QCOMPARE(db.rootGroup()->findGroupByPath("/group1/"), static_cast<Group*>(nullptr));
+    QCOMPARE(db.rootGroup()->findGroupByPath("/renamed/"), group1);
+    QCOMPARE(db.rootGroup()->findEntryByPath("/renamed/entry"), entry1);
+
+    group2->setParent(group1);
+    QCOMPARE(db.rootGroup()->findGroupByPath("/renamed/group2"), group2);
+    QCOMPARE(db.rootGroup()->findEntryByPath("/renamed/group2/entry"), entry2);
+    QCOMPARE(db.rootGroup()->findEntryByPath("/group2/entry"), static_cast<Entry*>(nullptr));
+
+    entry1->setTitle("first");
+    QCOMPARE(db.rootGroup()->findEntryByPath("entry"), entry2);
+    QCOMPARE(db.rootGroup()->findEntryByPath("renamed/first"), entry1);
+
+    delete entry2;
+    QCOMPARE(db.rootGroup()->findEntryByPath("entry"), static_cast<Entry*>(nullptr));
+    QCOMPARE(db.rootGroup()->locate("first"), QStringList({"/renamed/first"}));
+
+    // Lookups below the root group still work relative to that group
+    QCOMPARE(group1->findEntryByPath("/first"), entry1);
+    QCOMPARE(group1->findGroupByPath("/group2/"), group2);
+}
+
 void TestGroup::testPrint()
 {
     QScopedPointer<Database> db(new Database());
@@ -1208,3 +1254,61 @@ void TestGroup::testUsernamesRecursive()
     QVERIFY(usernames.contains("Name2"));
     QVERIFY(usernames.indexOf("Name2") < usernames.indexOf("Name1"));
 }
+
+void TestGroup::testWalkRecursive()
+{
+    Database database;
+    Group* root = database.rootGroup();
+
+    Group* group1 = new Group();
+    group1->setName("group1");
+    group1->setParent(root);
+    Group* group2 = new Group();
+    group2->setName("group2");
+    group2->setParent(group1);
+    Group* group3 = new Group();
+    group3->setName("group3");
+    group3->setParent(root);
+
+    Entry* entry1 = root->addEntryWithPath("entry1");
+    Entry* entry2 = group2->addEntryWithPath("entry2");
+    Entry* entry3 = group3->addEntryWithPath("entry3");
+    entry2->beginUpdate();
+    entry2->setTitle("entry2 renamed");
+    entry2->endUpdate();
+    QCOMPARE(entry2->historyItems().size(), 1);
+
+    // Walks visit items in the same order as the recursive lists
+    QList<Group*> groups;
+    QVERIFY(!root->walkGroups(
+        [&groups](Group* group) {
+            groups.append(group);
+            return false;
+        },
+        true));
+    QCOMPARE(groups, root->groupsRecursive(true));
+    QCOMPARE(groups, QList<Group*>() << root << group1 << group2 << group3);
+
+    QList<Entry*> entries;
+    QVERIFY(!root->walkEntries(
+        [&entries](Entry* entry) {
+            entries.append(entry);
+            return false;
+        },
+        true));
+    QCOMPARE(entries, root->entriesRecursive(true));
+    QCOMPARE(entries.size(), 4);
+    QCOMPARE(root->entriesRecursive(false), QList<Entry*>() << entry1 << entry2 << entry3);
+
+    // Returning true stops the walk
+    int visited = 0;
+    QVERIFY(root->walkEntries([&visited, entry2](Entry* entry) {
+        ++visited;
+        return entry == entry2;
+    }));
+    QCOMPARE(visited, 2);
+
+    QCOMPARE(root->findGroupByUuid(group2->uuid()), group2);
+    QCOMPARE(root->findEntryByUuid(entry3->uuid()), entry3);
+    QVERIFY(!group1->findEntryByUuid(entry3->uuid()));
+}
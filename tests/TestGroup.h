@@ -39,6 +39,7 @@ private slots:
     void testCopyCustomIcons();
     void testFindEntry();
     void testFindGroupByPath();
+    void testFindByPathAfterChanges();
     void testPrint();
     void testLocate();
     void testAddEntryWithPath();
@@ -49,6 +50,7 @@ private slots:
     void testHierarchy();
     void testApplyGroupIconRecursively();
     void testUsernamesRecursive();
+    void testWalkRecursive();
 };
 
 #endif // KEEPASSX_TESTGROUP_H
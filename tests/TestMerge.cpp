@@ -108,6 +108,40 @@ void TestMerge::testMergeNoChanges()
     QCOMPARE(dbSource->rootGroup()->entriesRecursive().size(), 2);
 }
 
+/**
+ * Entries found identical while planning the merge are
+ * skipped, changed entries are still merged.
+ */
+void TestMerge::testMergeUnchangedEntries()
+{
+    QScopedPointer<Database> dbDestination(createTestDatabase());
+    QScopedPointer<Database> dbSource(
+        createTestDatabaseStructureClone(dbDestination.data(), Entry::CloneIncludeHistory, Group::CloneIncludeEntries));
+
+    m_clock->advanceSecond(1);
+
+    Merger merger1(dbSource.data(), dbDestination.data());
+    QVERIFY(merger1.merge().isEmpty());
+    QCOMPARE(merger1.statistics().entries, 2);
+    QCOMPARE(merger1.statistics().unchangedEntries, 2);
+
+    m_clock->advanceSecond(1);
+
+    Entry* entry1Source = dbSource->rootGroup()->findEntryByPath("entry1");
+    QVERIFY(entry1Source);
+    entry1Source->beginUpdate();
+    entry1Source->setTitle("entry1 updated");
+    entry1Source->endUpdate();
+
+    m_clock->advanceSecond(1);
+
+    Merger merger2(dbSource.data(), dbDestination.data());
+    QVERIFY(!merger2.merge().isEmpty());
+    QCOMPARE(merger2.statistics().unchangedEntries, 1);
+    QVERIFY(dbDestination->rootGroup()->findEntryByPath("entry1 updated"));
+    QCOMPARE(dbDestination->rootGroup()->entriesRecursive().size(), 2);
+}
+
 /**
  * If the entry is updated in the source database, the update
  * should propagate in the destination database.
@@ -1436,6 +1470,58 @@ void TestMerge::testDeletedRevertedGroup()
     QVERIFY(group2DestinationMerged->notes() == "Updated");
 }
 
+/**
+ * Nested groups deleted in the source are removed from the destination
+ * regardless of the order of their deleted objects, and the merge
+ * reports which items it visited.
+ */
+void TestMerge::testDeletedNestedGroups()
+{
+    QScopedPointer<Database> dbDestination(createTestDatabase());
+
+    Group* group3 = new Group();
+    group3->setName("group3");
+    group3->setUuid(QUuid::createUuid());
+    group3->setParent(dbDestination->rootGroup());
+    Group* group4 = new Group();
+    group4->setName("group4");
+    group4->setUuid(QUuid::createUuid());
+    group4->setParent(group3);
+    const QUuid group3Uuid = group3->uuid();
+    const QUuid group4Uuid = group4->uuid();
+
+    QScopedPointer<Database> dbSource(
+        createTestDatabaseStructureClone(dbDestination.data(), Entry::CloneNoFlags, Group::CloneIncludeEntries));
+
+    m_clock->advanceSecond(1);
+
+    delete dbSource->rootGroup()->findGroupByUuid(group3Uuid);
+    QVERIFY(dbSource->containsDeletedObject(group3Uuid));
+    QVERIFY(dbSource->containsDeletedObject(group4Uuid));
+    // Parents before their children forces the merge to postpone the parent
+    QList<DeletedObject> deletions;
+    for (const DeletedObject& object : dbSource->deletedObjects()) {
+        deletions.prepend(object);
+    }
+    dbSource->setDeletedObjects(deletions);
+
+    m_clock->advanceSecond(1);
+
+    Merger merger(dbSource.data(), dbDestination.data());
+    merger.setForcedMergeMode(Group::Synchronize);
+    merger.merge();
+
+    QVERIFY(!dbDestination->rootGroup()->findGroupByUuid(group3Uuid));
+    QVERIFY(!dbDestination->rootGroup()->findGroupByUuid(group4Uuid));
+    QVERIFY(dbDestination->containsDeletedObject(group3Uuid));
+    QVERIFY(dbDestination->containsDeletedObject(group4Uuid));
+    QCOMPARE(dbDestination->deletedObjects().size(), 2);
+    QCOMPARE(dbDestination->rootGroup()->entriesRecursive().size(), 2);
+
+    QCOMPARE(merger.statistics().entries, 2);
+    QCOMPARE(merger.statistics().groups, 2);
+}
+
 /**
  * If the group is updated in the source database, and the
  * destination database after, the group should remain the
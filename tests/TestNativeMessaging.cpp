@@ -0,0 +1,331 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestNativeMessaging.h"
+#include "TestGlobal.h"
+#include "browser/NativeMessagingBase.h"
+
+#include <QEventLoop>
+#include <QLocalSocket>
+#include <QTimer>
+#include <cstring>
+
+QTEST_GUILESS_MAIN(TestNativeMessaging)
+
+namespace
+{
+    const int TimeoutMs = 5000;
+
+    // Only used to resolve the socket path the proxy connects to
+    class ServerPathProbe : public NativeMessagingBase
+    {
+    public:
+        ServerPathProbe()
+            : NativeMessagingBase(false)
+        {
+        }
+
+        QString path() const
+        {
+            return getLocalServerPath();
+        }
+
+        QString framedPath() const
+        {
+            return getFramedServerPath();
+        }
+
+    protected:
+        void handleNativeMessage(const QByteArray& message) override
+        {
+            Q_UNUSED(message);
+        }
+    };
+
+    QByteArray frame(const QByteArray& payload)
+    {
+        const quint32 length = static_cast<quint32>(payload.size());
+        return QByteArray(reinterpret_cast<const char*>(&length), sizeof(length)) + payload;
+    }
+
+    QByteArray message(int id)
+    {
+        return QString("{\"action\":\"test-associate\",\"requestID\":\"%1\"}").arg(id).toUtf8();
+    }
+} // namespace
+
+void TestNativeMessaging::initTestCase()
+{
+    QVERIFY(m_runtimeDir.isValid());
+    QVERIFY(QFile::exists(KEEPASSXC_PROXY_PATH));
+
+    // Keep the stand-in server away from a running KeePassXC instance
+    qputenv("XDG_RUNTIME_DIR", m_runtimeDir.path().toLocal8Bit());
+    qputenv("TMPDIR", m_runtimeDir.path().toLocal8Bit());
+    qputenv("TMP", m_runtimeDir.path().toLocal8Bit());
+    qputenv("TEMP", m_runtimeDir.path().toLocal8Bit());
+}
+
+void TestNativeMessaging::init()
+{
+    startProxy(ServerPathProbe().framedPath());
+}
+
+void TestNativeMessaging::cleanup()
+{
+    stopProxy();
+}
+
+/**
+ * Start a stand-in KeePassXC server on the given path and a proxy connecting to it.
+ */
+void TestNativeMessaging::startProxy(const QString& serverPath)
+{
+    QLocalServer::removeServer(serverPath);
+    QVERIFY(m_server.listen(serverPath));
+
+    // Echo every request back under its request ID, like KeePassXC answering the browser
+    connect(&m_server, &QLocalServer::newConnection, this, [this] {
+        m_client = m_server.nextPendingConnection();
+        connect(m_client, &QLocalSocket::readyRead, m_client, [this] {
+            const QByteArray magic = NativeMessagingBase::proxyProtocolMagic();
+            if (!m_framed && !m_legacy) {
+                if (m_client->bytesAvailable() < magic.size()) {
+                    return;
+                }
+                m_framed = m_client->peek(magic.size()) == magic;
+                m_legacy = !m_framed;
+                if (m_framed) {
+                    m_client->read(magic.size());
+                }
+            }
+
+            if (m_legacy) {
+                m_client->write(m_client->readAll());
+                return;
+            }
+
+            quint32 requestId = 0;
+            QByteArray payload;
+            while (NativeMessagingBase::readProxyFrame(m_client, &requestId, &payload)) {
+                m_requestIds.append(requestId);
+                m_client->write(NativeMessagingBase::buildProxyFrame(requestId, payload));
+            }
+        });
+    });
+
+    m_output.clear();
+    m_replies.clear();
+    m_replyCount = 0;
+    m_requestIds.clear();
+    m_framed = false;
+    m_legacy = false;
+    m_proxy.start(KEEPASSXC_PROXY_PATH, QStringList());
+    QVERIFY(m_proxy.waitForStarted(TimeoutMs));
+    QTRY_VERIFY_WITH_TIMEOUT(m_client, TimeoutMs);
+}
+
+void TestNativeMessaging::stopProxy()
+{
+    m_server.disconnect(this);
+    if (m_proxy.state() != QProcess::NotRunning) {
+        m_proxy.closeWriteChannel();
+        if (!m_proxy.waitForFinished(TimeoutMs)) {
+            m_proxy.kill();
+            m_proxy.waitForFinished();
+        }
+    }
+    delete m_client;
+    m_server.close();
+}
+
+void TestNativeMessaging::testProxyRoundTrip()
+{
+    QByteArray expected;
+    for (int i = 0; i < 10; ++i) {
+        expected.append(message(i));
+        m_proxy.write(frame(message(i)));
+        QVERIFY(waitForReplies(expected.size()));
+    }
+    QCOMPARE(m_replies, expected);
+
+    // Several frames in a single write, each reply must still arrive as its own native message
+    QByteArray batch;
+    for (int i = 10; i < 20; ++i) {
+        expected.append(message(i));
+        batch.append(frame(message(i)));
+    }
+    m_proxy.write(batch);
+    QVERIFY(waitForReplies(expected.size()));
+    QCOMPARE(m_replies, expected);
+    QCOMPARE(m_replyCount, 20);
+
+    QVERIFY(m_framed);
+    QCOMPARE(m_requestIds.size(), 20);
+    for (int i = 0; i < m_requestIds.size(); ++i) {
+        QCOMPARE(m_requestIds.at(i), static_cast<quint32>(i + 1));
+    }
+}
+
+void TestNativeMessaging::testProxyUnrequestedReplies()
+{
+    m_proxy.write(frame(message(1)));
+    QVERIFY(waitForReplies(message(1).size()));
+
+    // Notifications like database-locked use request ID 0 and may share a write with other replies
+    const QByteArray locked("{\"action\":\"database-locked\"}");
+    const QByteArray unlocked("{\"action\":\"database-unlocked\"}");
+    m_client->write(NativeMessagingBase::buildProxyFrame(0, locked)
+                    + NativeMessagingBase::buildProxyFrame(0, unlocked));
+    QVERIFY(waitForReplies(message(1).size() + locked.size() + unlocked.size()));
+    QCOMPARE(m_replyCount, 3);
+    QCOMPARE(m_replies, message(1) + locked + unlocked);
+}
+
+void TestNativeMessaging::testProxyLargeReply()
+{
+    // Like a get-logins reply for a wildcard domain with many entries
+    QByteArray payload("{\"action\":\"get-logins\",\"entries\":\"");
+    payload.append(QByteArray(512 * 1024, 'x'));
+    payload.append("\"}");
+
+    m_proxy.write(frame(payload));
+    QVERIFY(waitForReplies(payload.size()));
+    QCOMPARE(m_replyCount, 1);
+    QCOMPARE(m_replies, payload);
+}
+
+void TestNativeMessaging::testProxyPartialFrames()
+{
+    const QByteArray payload = message(42);
+    const QByteArray data = frame(payload);
+
+    // Split inside the length prefix and inside the payload
+    m_proxy.write(data.left(2));
+    m_proxy.waitForBytesWritten(TimeoutMs);
+    QTest::qWait(50);
+    m_proxy.write(data.mid(2, 10));
+    m_proxy.waitForBytesWritten(TimeoutMs);
+    QTest::qWait(50);
+    QVERIFY(m_replies.isEmpty());
+
+    m_proxy.write(data.mid(12));
+    QVERIFY(waitForReplies(payload.size()));
+    QCOMPARE(m_replies, payload);
+}
+
+void TestNativeMessaging::testProxyClosesOnEof()
+{
+    m_proxy.write(frame(message(1)));
+    QVERIFY(waitForReplies(message(1).size()));
+
+    m_proxy.closeWriteChannel();
+    QVERIFY(m_proxy.waitForFinished(TimeoutMs));
+    QCOMPARE(m_proxy.exitStatus(), QProcess::NormalExit);
+}
+
+void TestNativeMessaging::testProxyClosesOnOversizedFrame()
+{
+    // The length prefix alone, the proxy must not wait for a payload it will never buffer
+    const quint32 length = NATIVE_MSG_MAX_LENGTH + 1;
+    m_proxy.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    QVERIFY(m_proxy.waitForFinished(TimeoutMs));
+    QCOMPARE(m_proxy.exitStatus(), QProcess::NormalExit);
+    QVERIFY(m_replies.isEmpty());
+}
+
+void TestNativeMessaging::testProxyClosesOnOversizedReply()
+{
+    // A frame header KeePassXC could never complete within the proxy's read buffer
+    m_client->write(QByteArray(PROXY_FRAME_HEADER_LENGTH, '\xff'));
+    QVERIFY(m_proxy.waitForFinished(TimeoutMs));
+    QCOMPARE(m_proxy.exitStatus(), QProcess::NormalExit);
+    QVERIFY(m_replies.isEmpty());
+}
+
+void TestNativeMessaging::testProxyLegacyServer()
+{
+    // Older KeePassXC versions only listen on the legacy path and expect bare messages
+    stopProxy();
+    startProxy(ServerPathProbe().path());
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    m_proxy.write(frame(message(1)));
+    QVERIFY(waitForReplies(message(1).size()));
+    QCOMPARE(m_replies, message(1));
+    QVERIFY(m_legacy);
+    QVERIFY(m_requestIds.isEmpty());
+}
+
+void TestNativeMessaging::benchmarkProxyLatency()
+{
+    QByteArray env = qgetenv("BENCHMARK");
+
+    if (env.isEmpty() || env == "0" || env == "no") {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    const QByteArray request = frame(message(1));
+    int expected = 0;
+
+    // One request/reply round trip through keepassxc-proxy
+    QBENCHMARK
+    {
+        expected += message(1).size();
+        m_proxy.write(request);
+        QVERIFY(waitForReplies(expected));
+    };
+}
+
+/**
+ * Run the event loop until the proxy has written back at least
+ * the given number of payload bytes, stripping the frame headers.
+ */
+bool TestNativeMessaging::waitForReplies(int payloadSize)
+{
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+    auto readFrames = [&] {
+        m_output.append(m_proxy.readAllStandardOutput());
+        while (m_output.size() >= static_cast<int>(sizeof(quint32))) {
+            quint32 length = 0;
+            memcpy(&length, m_output.constData(), sizeof(length));
+            if (m_output.size() - static_cast<int>(sizeof(length)) < static_cast<int>(length)) {
+                break;
+            }
+            m_replies.append(m_output.mid(sizeof(length), length));
+            ++m_replyCount;
+            m_output.remove(0, sizeof(length) + length);
+        }
+        if (m_replies.size() >= payloadSize) {
+            loop.quit();
+        }
+    };
+    connect(&m_proxy, &QProcess::readyReadStandardOutput, &loop, readFrames);
+
+    readFrames();
+    if (m_replies.size() < payloadSize) {
+        timeout.start(TimeoutMs);
+        loop.exec();
+    }
+    return m_replies.size() >= payloadSize;
+}
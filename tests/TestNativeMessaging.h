@@ -0,0 +1,65 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_TESTNATIVEMESSAGING_H
+#define KEEPASSXC_TESTNATIVEMESSAGING_H
+
+#include <QLocalServer>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QTemporaryDir>
+
+class QLocalSocket;
+
+class TestNativeMessaging : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testProxyRoundTrip();
+    void testProxyUnrequestedReplies();
+    void testProxyLargeReply();
+    void testProxyPartialFrames();
+    void testProxyClosesOnEof();
+    void testProxyClosesOnOversizedFrame();
+    void testProxyClosesOnOversizedReply();
+    void testProxyLegacyServer();
+    void benchmarkProxyLatency();
+
+private:
+    void startProxy(const QString& serverPath);
+    void stopProxy();
+    bool waitForReplies(int payloadSize);
+
+    QTemporaryDir m_runtimeDir;
+    QLocalServer m_server;
+    QPointer<QLocalSocket> m_client;
+    QProcess m_proxy;
+    QByteArray m_output;
+    QByteArray m_replies;
+    int m_replyCount = 0;
+    QList<quint32> m_requestIds;
+    bool m_framed = false;
+    bool m_legacy = false;
+};
+
+#endif // KEEPASSXC_TESTNATIVEMESSAGING_H
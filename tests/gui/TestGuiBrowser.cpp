@@ -24,13 +24,19 @@
 #include <QApplication>
 #include <QDebug>
 #include <QDialogButtonBox>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QLineEdit>
 #include <QListView>
+#include <QLocalSocket>
 #include <QPlainTextEdit>
 #include <QPushButton>
 #include <QTableView>
+#include <QTemporaryDir>
 #include <QToolBar>
 
+#include "browser/BrowserSettings.h"
+#include "browser/NativeMessagingHost.h"
 #include "config-keepassx-tests.h"
 #include "core/Bootstrap.h"
 #include "core/Config.h"
@@ -49,6 +55,40 @@
 
 QTEST_MAIN(TestGuiBrowser)
 
+namespace
+{
+    // Only used to resolve the socket path keepassxc-proxy connects to
+    class ServerPathProbe : public NativeMessagingBase
+    {
+    public:
+        ServerPathProbe()
+            : NativeMessagingBase(false)
+        {
+        }
+
+        QString framedPath() const
+        {
+            return getFramedServerPath();
+        }
+
+    protected:
+        void handleNativeMessage(const QByteArray& message) override
+        {
+            Q_UNUSED(message);
+        }
+    };
+
+    QByteArray request(const QString& action)
+    {
+        QJsonObject json;
+        json["action"] = action;
+        json["clientID"] = QString("testClient");
+        json["nonce"] = QString("zBKdvTjL5bgWaKMCTut/8soM/uoMrFoZ");
+        json["publicKey"] = QString("UIIPObeoya1G8g1M5omgyoPR/j1mR1HlYHu0wHCgMhA=");
+        return QJsonDocument(json).toJson(QJsonDocument::Compact);
+    }
+} // namespace
+
 void TestGuiBrowser::initTestCase()
 {
     QVERIFY(Crypto::init());
@@ -226,6 +266,50 @@ void TestGuiBrowser::testAdditionalURLs()
     }
 }
 
+void TestGuiBrowser::testRequestOrder()
+{
+    // Keep the server away from a running KeePassXC instance
+    QTemporaryDir runtimeDir;
+    QVERIFY(runtimeDir.isValid());
+    qputenv("XDG_RUNTIME_DIR", runtimeDir.path().toLocal8Bit());
+    qputenv("TMPDIR", runtimeDir.path().toLocal8Bit());
+
+    browserSettings()->setUpdateBinaryPath(false);
+    browserSettings()->setSupportBrowserProxy(true);
+    browserSettings()->setEnabled(true);
+    NativeMessagingHost host(m_tabWidget);
+
+    QLocalSocket socket;
+    socket.connectToServer(ServerPathProbe().framedPath());
+    QVERIFY(socket.waitForConnected(5000));
+
+    QList<quint32> replyIds;
+    QStringList replyActions;
+    connect(&socket, &QLocalSocket::readyRead, &socket, [&] {
+        quint32 requestId = 0;
+        QByteArray payload;
+        while (NativeMessagingBase::readProxyFrame(&socket, &requestId, &payload)) {
+            replyIds.append(requestId);
+            replyActions.append(QJsonDocument::fromJson(payload).object().value("action").toString());
+        }
+    });
+
+    // get-databasehash is served from the pool and waits for the GUI thread, change-public-keys
+    // is answered on the GUI thread right away. Replies must still follow the requests.
+    socket.write(NativeMessagingBase::proxyProtocolMagic()
+                 + NativeMessagingBase::buildProxyFrame(1, request("get-databasehash"))
+                 + NativeMessagingBase::buildProxyFrame(2, request("change-public-keys"))
+                 + NativeMessagingBase::buildProxyFrame(3, request("get-databasehash")));
+    socket.flush();
+
+    QTRY_COMPARE_WITH_TIMEOUT(replyIds.size(), 3, 5000);
+    QCOMPARE(replyIds, QList<quint32>({1, 2, 3}));
+    QCOMPARE(replyActions, QStringList({"get-databasehash", "change-public-keys", "get-databasehash"}));
+
+    socket.disconnectFromServer();
+    browserSettings()->setEnabled(false);
+}
+
 void TestGuiBrowser::triggerAction(const QString& name)
 {
     auto* action = m_mainWindow->findChild<QAction*>(name);
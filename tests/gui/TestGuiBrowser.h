@@ -45,6 +45,7 @@ private slots:
 
     void testEntrySettings();
     void testAdditionalURLs();
+    void testRequestOrder();
 
 private:
     void triggerAction(const QString& name);
@@ -0,0 +1,282 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestGuiBrowserLoad.h"
+#include "TestGlobal.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QUrl>
+#include <QUuid>
+
+#include "browser/BrowserAction.h"
+#include "browser/BrowserService.h"
+#include "browser/BrowserSettings.h"
+#include "config-keepassx-tests.h"
+#include "core/Config.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Global.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+#include "crypto/Crypto.h"
+#include "gui/DatabaseTabWidget.h"
+#include "gui/DatabaseWidget.h"
+#include "sodium/crypto_box.h"
+#include "sodium/randombytes.h"
+
+#include <algorithm>
+
+QTEST_MAIN(TestGuiBrowserLoad)
+
+namespace
+{
+    const QString ClientId = QStringLiteral("load-test");
+    // Every trace is replayed this many times per data set
+    const int Rounds = 20;
+    // One entry in this many matches a site of the trace, the rest is noise
+    const int MatchingEntryRatio = 10;
+
+    QByteArray randomBytes(int size)
+    {
+        QByteArray bytes(size, '\0');
+        randombytes_buf(bytes.data(), bytes.size());
+        return bytes;
+    }
+
+    const unsigned char* constUchar(const QByteArray& bytes)
+    {
+        return reinterpret_cast<const unsigned char*>(bytes.constData());
+    }
+} // namespace
+
+void TestGuiBrowserLoad::initTestCase()
+{
+    QByteArray env = qgetenv("BENCHMARK");
+
+    if (env.isEmpty() || env == "0" || env == "no") {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QVERIFY(Crypto::init());
+    Config::createTempFileInstance();
+    browserSettings()->setAlwaysAllowAccess(true);
+    browserSettings()->setSearchInAllDatabases(false);
+
+    QFile traceFile(QString(KEEPASSX_TEST_DATA_DIR).append("/BrowserGetLogins.json"));
+    QVERIFY(traceFile.open(QIODevice::ReadOnly));
+    m_trace = QJsonDocument::fromJson(traceFile.readAll()).array();
+    QVERIFY(!m_trace.isEmpty());
+
+    m_idKey = randomBytes(crypto_box_PUBLICKEYBYTES).toBase64();
+    m_tabWidget.reset(new DatabaseTabWidget());
+    m_browserService.reset(new BrowserService(m_tabWidget.data()));
+    m_browserAction.reset(new BrowserAction(*m_browserService));
+}
+
+void TestGuiBrowserLoad::cleanupTestCase()
+{
+    m_browserAction.reset();
+    m_browserService.reset();
+    m_tabWidget.reset();
+}
+
+void TestGuiBrowserLoad::benchmarkGetLogins_data()
+{
+    QTest::addColumn<int>("entries");
+    QTest::addColumn<int>("additionalUrls");
+
+    QTest::newRow("1000 entries") << 1000 << 0;
+    QTest::newRow("1000 entries, 5 additional URLs") << 1000 << 5;
+    QTest::newRow("10000 entries") << 10000 << 0;
+    QTest::newRow("10000 entries, 5 additional URLs") << 10000 << 5;
+}
+
+void TestGuiBrowserLoad::benchmarkGetLogins()
+{
+    QFETCH(int, entries);
+    QFETCH(int, additionalUrls);
+
+    auto* dbWidget = new DatabaseWidget(createDatabase(entries, additionalUrls), m_tabWidget.data());
+    m_tabWidget->addDatabaseTab(dbWidget);
+    QVERIFY(connectClient());
+
+    QJsonArray keys;
+    QJsonObject key;
+    key["id"] = ClientId;
+    key["key"] = m_idKey;
+    keys.append(key);
+
+    // Encrypt all requests up front so only the KeePassXC side is measured
+    QList<QJsonObject> requests;
+    for (int round = 0; round < Rounds; ++round) {
+        for (const QJsonValue& recorded : asConst(m_trace)) {
+            QJsonObject message = recorded.toObject();
+            message["action"] = QString("get-logins");
+            message["id"] = ClientId;
+            message["keys"] = keys;
+            requests.append(buildRequest("get-logins", message));
+        }
+    }
+
+    // Warm up the URL index and entry caches, like a browser session would
+    for (int i = 0; i < m_trace.size(); ++i) {
+        m_browserAction->readResponse(requests.at(i));
+    }
+
+    QVector<qint64> latencies;
+    latencies.reserve(requests.size());
+    int hits = 0;
+
+    QElapsedTimer total;
+    QElapsedTimer timer;
+    total.start();
+    for (const QJsonObject& request : asConst(requests)) {
+        timer.start();
+        const QJsonObject response = m_browserAction->readResponse(request);
+        latencies.append(timer.nsecsElapsed());
+        if (response.contains("message")) {
+            ++hits;
+        }
+    }
+    const qint64 elapsed = total.nsecsElapsed();
+
+    std::sort(latencies.begin(), latencies.end());
+    const double p50 = latencies.at(latencies.size() / 2) / 1e6;
+    const double p99 = latencies.at(qMin(latencies.size() - 1, latencies.size() * 99 / 100)) / 1e6;
+    const double requestsPerSecond = latencies.size() * 1e9 / elapsed;
+
+    qDebug().noquote() << QString("%1: %2 requests (%3 with logins), p50 %4 ms, p99 %5 ms, %6 requests/s")
+                              .arg(QTest::currentDataTag())
+                              .arg(latencies.size())
+                              .arg(hits)
+                              .arg(p50, 0, 'f', 3)
+                              .arg(p99, 0, 'f', 3)
+                              .arg(requestsPerSecond, 0, 'f', 0);
+    QTest::setBenchmarkResult(requestsPerSecond, QTest::Events);
+
+    QVERIFY(hits > 0);
+    delete dbWidget;
+}
+
+/**
+ * Build a database with one entry in MatchingEntryRatio on a site of the
+ * recorded trace and unrelated sites for all other entries.
+ */
+QSharedPointer<Database> TestGuiBrowserLoad::createDatabase(int entries, int additionalUrls) const
+{
+    auto db = QSharedPointer<Database>::create();
+    db->setInitialized(true);
+    db->metadata()->customData()->set(BrowserService::ASSOCIATE_KEY_PREFIX + ClientId, m_idKey);
+
+    auto* root = db->rootGroup();
+    for (int i = 0; i < entries; ++i) {
+        QString url = QString("https://service%1.example%2.net/login").arg(i).arg(i % 50);
+        if (i % MatchingEntryRatio == 0) {
+            const QUrl site(m_trace.at((i / MatchingEntryRatio) % m_trace.size()).toObject().value("url").toString());
+            url = site.toString(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment);
+        }
+
+        auto* entry = new Entry();
+        entry->setUuid(QUuid::createUuid());
+        entry->beginUpdate();
+        entry->setTitle(QString("Entry %1").arg(i));
+        entry->setUsername(QString("user%1").arg(i));
+        entry->setPassword(QString("password%1").arg(i));
+        entry->setUrl(url);
+        for (int j = 0; j < additionalUrls; ++j) {
+            const QString key =
+                j == 0 ? BrowserService::ADDITIONAL_URL : QString("%1_%2").arg(BrowserService::ADDITIONAL_URL).arg(j);
+            entry->attributes()->set(key, QString("https://alt%1.service%2.example.org").arg(j).arg(i));
+        }
+        entry->endUpdate();
+        entry->setGroup(root);
+    }
+
+    return db;
+}
+
+/**
+ * Exchange keys and associate like KeePassXC-Browser does when it connects.
+ */
+bool TestGuiBrowserLoad::connectClient()
+{
+    m_clientPublicKey.resize(crypto_box_PUBLICKEYBYTES);
+    m_clientSecretKey.resize(crypto_box_SECRETKEYBYTES);
+    crypto_box_keypair(reinterpret_cast<unsigned char*>(m_clientPublicKey.data()),
+                       reinterpret_cast<unsigned char*>(m_clientSecretKey.data()));
+
+    QJsonObject keyExchange;
+    keyExchange["action"] = QString("change-public-keys");
+    keyExchange["publicKey"] = QString(m_clientPublicKey.toBase64());
+    keyExchange["nonce"] = QString(randomBytes(crypto_box_NONCEBYTES).toBase64());
+    keyExchange["clientID"] = ClientId;
+    const QJsonObject keyResponse = m_browserAction->readResponse(keyExchange);
+    m_serverPublicKey = QByteArray::fromBase64(keyResponse.value("publicKey").toString().toUtf8());
+    if (m_serverPublicKey.size() != crypto_box_PUBLICKEYBYTES) {
+        return false;
+    }
+
+    QJsonObject associate;
+    associate["action"] = QString("test-associate");
+    associate["id"] = ClientId;
+    associate["key"] = m_idKey;
+    const QJsonObject response = m_browserAction->readResponse(buildRequest("test-associate", associate));
+    return decryptResponse(response).value("success").toString() == TRUE_STR;
+}
+
+QJsonObject TestGuiBrowserLoad::buildRequest(const QString& action, const QJsonObject& message) const
+{
+    const QByteArray nonce = randomBytes(crypto_box_NONCEBYTES);
+    const QByteArray plain = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    QByteArray encrypted(plain.size() + crypto_box_MACBYTES, '\0');
+    crypto_box_easy(reinterpret_cast<unsigned char*>(encrypted.data()),
+                    constUchar(plain),
+                    plain.size(),
+                    constUchar(nonce),
+                    constUchar(m_serverPublicKey),
+                    constUchar(m_clientSecretKey));
+
+    QJsonObject request;
+    request["action"] = action;
+    request["message"] = QString(encrypted.toBase64());
+    request["nonce"] = QString(nonce.toBase64());
+    request["clientID"] = ClientId;
+    return request;
+}
+
+QJsonObject TestGuiBrowserLoad::decryptResponse(const QJsonObject& response) const
+{
+    const QByteArray encrypted = QByteArray::fromBase64(response.value("message").toString().toUtf8());
+    const QByteArray nonce = QByteArray::fromBase64(response.value("nonce").toString().toUtf8());
+    if (encrypted.size() < static_cast<int>(crypto_box_MACBYTES) || nonce.size() != crypto_box_NONCEBYTES) {
+        return {};
+    }
+
+    QByteArray plain(encrypted.size() - crypto_box_MACBYTES, '\0');
+    if (crypto_box_open_easy(reinterpret_cast<unsigned char*>(plain.data()),
+                             constUchar(encrypted),
+                             encrypted.size(),
+                             constUchar(nonce),
+                             constUchar(m_serverPublicKey),
+                             constUchar(m_clientSecretKey))
+        != 0) {
+        return {};
+    }
+    return QJsonDocument::fromJson(plain).object();
+}
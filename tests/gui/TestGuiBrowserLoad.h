@@ -0,0 +1,67 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_TESTGUIBROWSERLOAD_H
+#define KEEPASSXC_TESTGUIBROWSERLOAD_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+class BrowserAction;
+class BrowserService;
+class Database;
+class DatabaseTabWidget;
+
+/**
+ * Load test for the browser integration.
+ *
+ * Replays recorded get-logins traffic through BrowserAction against
+ * synthetic databases and reports latency percentiles and throughput.
+ * Only runs with BENCHMARK=1 set in the environment.
+ */
+class TestGuiBrowserLoad : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkGetLogins_data();
+    void benchmarkGetLogins();
+
+private:
+    QSharedPointer<Database> createDatabase(int entries, int additionalUrls) const;
+    bool connectClient();
+    QJsonObject buildRequest(const QString& action, const QJsonObject& message) const;
+    QJsonObject decryptResponse(const QJsonObject& response) const;
+
+    QScopedPointer<DatabaseTabWidget> m_tabWidget;
+    QScopedPointer<BrowserService> m_browserService;
+    QScopedPointer<BrowserAction> m_browserAction;
+    QJsonArray m_trace;
+
+    QByteArray m_clientPublicKey;
+    QByteArray m_clientSecretKey;
+    QByteArray m_serverPublicKey;
+    QString m_idKey;
+};
+
+#endif // KEEPASSXC_TESTGUIBROWSERLOAD_H